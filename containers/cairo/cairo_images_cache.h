@@ -1,9 +1,17 @@
 #ifndef LITEHTML_CAIRO_IMAGES_CACHE_H
 #define LITEHTML_CAIRO_IMAGES_CACHE_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <list>
 #include <mutex>
-#include <map>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <cairo.h>
 
 class cairo_surface_wrapper
@@ -44,6 +52,19 @@ class cairo_surface_wrapper
         }
         return *this;
     }
+    cairo_surface_wrapper& operator=(cairo_surface_wrapper&& v) noexcept
+    {
+        if(this != &v)
+        {
+            if(surface)
+            {
+                cairo_surface_destroy(surface);
+            }
+            surface   = v.surface;
+            v.surface = nullptr;
+        }
+        return *this;
+    }
     ~cairo_surface_wrapper()
     {
         if(surface)
@@ -55,48 +76,400 @@ class cairo_surface_wrapper
     {
         return cairo_surface_reference(surface);
     }
+    bool empty() const
+    {
+        return surface == nullptr;
+    }
+    // Memory used by the surface pixels. Non-image surfaces are not counted.
+    size_t size_in_bytes() const
+    {
+        if(!surface || cairo_surface_get_type(surface) != CAIRO_SURFACE_TYPE_IMAGE)
+        {
+            return 0;
+        }
+        return static_cast<size_t>(cairo_image_surface_get_stride(surface)) *
+               static_cast<size_t>(cairo_image_surface_get_height(surface));
+    }
 };
 
+/// @brief Cache of the decoded images and their scaled copies.
+///
+/// When the memory budget is set (see set_budget), the least recently used images of the whole cache are released to
+/// keep it within the budget. The released image is removed from the cache, so get_image returns nullptr and reserve
+/// returns true for it again: the owner loads it again like a new image. The images used in the current and the
+/// previous frame are never released (see next_frame), so the cache can exceed the budget while the visible images
+/// don't fit it. The budget is unlimited by default.
+///
+/// The cache is split into shards by the url hash, every shard has its own lock, so the drawing threads don't wait
+/// each other while accessing different images. The budget and the usage order are global: every shard keeps its
+/// entries in the usage order, and the oldest tail of all shards is released first.
 class cairo_images_cache
 {
-    std::mutex                                   m_mutex;
-    std::map<std::string, cairo_surface_wrapper> m_images;
+  public:
+    using scale_function_t = std::function<cairo_surface_t*(cairo_surface_t* surface, int width, int height)>;
+
+    struct statistics
+    {
+        size_t hits          = 0; // get_image found the image
+        size_t misses        = 0; // get_image didn't find the image
+        size_t scaled_hits   = 0; // get_scaled_image found the scaled copy
+        size_t scaled_misses = 0; // get_scaled_image had to scale the image
+        size_t evictions     = 0; // images and scaled copies released to keep the budget
+        size_t images        = 0; // number of the cached images
+        size_t bytes         = 0; // memory used by the images and scaled copies
+    };
+
+  private:
+    // Number of the scaled copies kept for each image
+    static constexpr size_t max_scaled_copies = 4;
+    static constexpr size_t shards_count      = 8;
+
+    struct scaled_image
+    {
+        int                   width  = 0;
+        int                   height = 0;
+        cairo_surface_wrapper surface;
+    };
+
+    struct cache_entry
+    {
+        std::string               url;
+        cairo_surface_wrapper     image;
+        std::vector<scaled_image> scaled; // the most recently used first
+        size_t                    bytes     = 0;
+        uint64_t                  last_used = 0; // m_clock value of the last use
+        uint64_t                  frame     = 0; // m_frame value of the last use
+    };
+
+    using entries_list = std::list<cache_entry>;
+
+    struct shard
+    {
+        std::mutex                                              mutex;
+        entries_list                                            entries; // the most recently used first
+        std::unordered_map<std::string, entries_list::iterator> index;
+        statistics                                              stats; // bytes are counted in m_bytes
+    };
+
+    std::array<shard, shards_count> m_shards;
+    std::atomic<size_t>             m_budget{0};
+    std::atomic<size_t>             m_bytes{0};
+    std::atomic<uint64_t>           m_clock{0}; // orders the uses of the entries of all shards
+    std::atomic<uint64_t>           m_frame{0}; // 0 until next_frame is called
+    std::mutex                      m_evict_mutex;
 
   public:
+    /// @brief Set the memory budget of the cache.
+    /// @param bytes maximum memory used by the images and scaled copies, 0 means unlimited
+    void set_budget(size_t bytes)
+    {
+        m_budget = bytes;
+        enforce_budget(nullptr);
+    }
+
+    size_t get_budget() const
+    {
+        return m_budget;
+    }
+
+    /// @brief Start the next frame.
+    ///
+    /// The owner calls it after drawing a frame. The images used in the current and the previous frame are not
+    /// released to keep the budget, otherwise adding a visible image could release another visible one, and the owner
+    /// would load them in turn forever. If next_frame is never called, only the image being added is kept.
+    ///
+    /// The images kept over the budget are released here once they are not visible anymore.
+    void next_frame()
+    {
+        m_frame++;
+        enforce_budget(nullptr);
+    }
+
+    /// @brief Add image into the cache. The cache takes ownership of the image reference.
     void add_image(const std::string& url, cairo_surface_t* image)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        m_images[url] = cairo_surface_wrapper(image);
+        auto& sh = get_shard(url);
+        {
+            std::unique_lock<std::mutex> lock(sh.mutex);
+            auto                         iter = sh.index.find(url);
+            if(iter == sh.index.end())
+            {
+                sh.entries.emplace_front();
+                sh.entries.front().url = url;
+                iter                   = sh.index.emplace(url, sh.entries.begin()).first;
+            }
+            auto& entry  = *iter->second;
+            m_bytes     -= entry.bytes;
+            entry.image  = cairo_surface_wrapper(image);
+            entry.scaled.clear();
+            entry.bytes  = entry.image.size_in_bytes();
+            m_bytes     += entry.bytes;
+            use(sh, iter->second);
+        }
+        enforce_budget(&url);
     }
 
+    /// @brief Find image in the cache.
+    /// @return new reference to the image or nullptr
     cairo_surface_t* get_image(const std::string& url)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        auto                         iter = m_images.find(url);
-        if(iter != m_images.end())
+        auto&                        sh = get_shard(url);
+        std::unique_lock<std::mutex> lock(sh.mutex);
+        auto                         iter = sh.index.find(url);
+        if(iter == sh.index.end() || iter->second->image.empty())
         {
-            return iter->second.get();
+            sh.stats.misses++;
+            return nullptr;
         }
-        return nullptr;
+        sh.stats.hits++;
+        use(sh, iter->second);
+        return iter->second->image.get();
     }
 
+    /// @brief Find image scaled to the width and height.
+    ///
+    /// The scaled copy is created with scale_func on the first request and is kept until the image is released or
+    /// replaced.
+    /// @return new reference to the scaled image or nullptr if there is no image in the cache
+    cairo_surface_t* get_scaled_image(const std::string& url, int width, int height,
+                                      const scale_function_t& scale_func)
+    {
+        auto&                 sh = get_shard(url);
+        cairo_surface_wrapper source;
+        {
+            std::unique_lock<std::mutex> lock(sh.mutex);
+            auto                         iter = sh.index.find(url);
+            if(iter == sh.index.end() || iter->second->image.empty())
+            {
+                sh.stats.misses++;
+                return nullptr;
+            }
+            auto& entry = *iter->second;
+            use(sh, iter->second);
+            cairo_surface_t* img = entry.image.get();
+            if(cairo_image_surface_get_width(img) == width && cairo_image_surface_get_height(img) == height)
+            {
+                sh.stats.hits++;
+                return img;
+            }
+            for(auto scaled = entry.scaled.begin(); scaled != entry.scaled.end(); ++scaled)
+            {
+                if(scaled->width == width && scaled->height == height)
+                {
+                    sh.stats.scaled_hits++;
+                    std::rotate(entry.scaled.begin(), scaled, scaled + 1);
+                    cairo_surface_destroy(img);
+                    return entry.scaled.front().surface.get();
+                }
+            }
+            sh.stats.scaled_misses++;
+            source = cairo_surface_wrapper(img);
+        }
+
+        // Scale without lock, the other threads can use this shard meanwhile
+        cairo_surface_t* src    = source.get();
+        cairo_surface_t* result = scale_func(src, width, height);
+        cairo_surface_destroy(src);
+        if(!result)
+        {
+            return nullptr;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(sh.mutex);
+            auto                         iter = sh.index.find(url);
+            // The image could be replaced or released while scaling, the result is not cached in this case
+            if(iter == sh.index.end() || iter->second->image.empty())
+            {
+                return result;
+            }
+            auto&            entry = *iter->second;
+            cairo_surface_t* img   = entry.image.get();
+            bool             same  = img == src;
+            cairo_surface_destroy(img);
+            if(!same)
+            {
+                return result;
+            }
+            scaled_image item;
+            item.width   = width;
+            item.height  = height;
+            item.surface = cairo_surface_wrapper(cairo_surface_reference(result));
+            size_t bytes = item.surface.size_in_bytes();
+            entry.scaled.insert(entry.scaled.begin(), std::move(item));
+            entry.bytes += bytes;
+            m_bytes     += bytes;
+            while(entry.scaled.size() > max_scaled_copies)
+            {
+                remove_scaled(sh, entry);
+            }
+        }
+        enforce_budget(&url);
+        return result;
+    }
+
+    /// @brief Add empty entry for the url.
+    /// @return true if the url was not in the cache, it was never added or was released to keep the budget
     bool reserve(const std::string& url)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        auto                         iter = m_images.find(url);
-        if(iter == m_images.end())
+        auto&                        sh = get_shard(url);
+        std::unique_lock<std::mutex> lock(sh.mutex);
+        if(sh.index.find(url) != sh.index.end())
         {
-            m_images[url] = cairo_surface_wrapper();
-            return true;
+            return false;
         }
-        return false;
+        sh.entries.emplace_front();
+        sh.entries.front().url = url;
+        sh.index.emplace(url, sh.entries.begin());
+        use(sh, sh.entries.begin());
+        return true;
     }
 
     bool exists(const std::string& url)
     {
-        std::unique_lock<std::mutex> lock(m_mutex);
-        auto                         iter = m_images.find(url);
-        return iter != m_images.end();
+        auto&                        sh = get_shard(url);
+        std::unique_lock<std::mutex> lock(sh.mutex);
+        return sh.index.find(url) != sh.index.end();
+    }
+
+    /// @brief Release all images
+    void clear()
+    {
+        for(auto& sh : m_shards)
+        {
+            std::unique_lock<std::mutex> lock(sh.mutex);
+            for(const auto& entry : sh.entries)
+            {
+                m_bytes -= entry.bytes;
+            }
+            sh.entries.clear();
+            sh.index.clear();
+        }
+    }
+
+    statistics get_statistics()
+    {
+        statistics ret;
+        for(auto& sh : m_shards)
+        {
+            std::unique_lock<std::mutex> lock(sh.mutex);
+            ret.hits          += sh.stats.hits;
+            ret.misses        += sh.stats.misses;
+            ret.scaled_hits   += sh.stats.scaled_hits;
+            ret.scaled_misses += sh.stats.scaled_misses;
+            ret.evictions     += sh.stats.evictions;
+            for(const auto& entry : sh.entries)
+            {
+                if(!entry.image.empty())
+                {
+                    ret.images++;
+                }
+            }
+        }
+        ret.bytes = m_bytes;
+        return ret;
+    }
+
+  private:
+    shard& get_shard(const std::string& url)
+    {
+        return m_shards[std::hash<std::string>{}(url) % shards_count];
+    }
+
+    // Move the entry to the head of the shard list. Must be called with the shard lock.
+    void use(shard& sh, entries_list::iterator iter)
+    {
+        iter->last_used = ++m_clock;
+        iter->frame     = m_frame;
+        sh.entries.splice(sh.entries.begin(), sh.entries, iter);
+    }
+
+    // The entry was used in the current or the previous frame
+    bool in_use(const cache_entry& entry) const
+    {
+        uint64_t frame = m_frame;
+        return frame != 0 && entry.frame + 1 >= frame;
+    }
+
+    void remove_scaled(shard& sh, cache_entry& entry)
+    {
+        size_t bytes  = entry.scaled.back().surface.size_in_bytes();
+        entry.bytes  -= bytes;
+        m_bytes      -= bytes;
+        entry.scaled.pop_back();
+        sh.stats.evictions++;
+    }
+
+    // The least recently used entry of the shard that can be released, or the end of the list. The entries used in
+    // the current and the previous frame are used after all the others, so the search stops at the first of them.
+    // Must be called with the shard lock.
+    entries_list::iterator find_victim(shard& sh, const std::string* keep)
+    {
+        for(auto iter = sh.entries.rbegin(); iter != sh.entries.rend(); ++iter)
+        {
+            if(in_use(*iter))
+            {
+                break;
+            }
+            if(iter->bytes != 0 && !(keep && iter->url == *keep))
+            {
+                return std::prev(iter.base());
+            }
+        }
+        return sh.entries.end();
+    }
+
+    // Release the least recently used data of all shards until the cache fits the budget. The keep entry is being
+    // used and is never released. Must be called without the shard locks.
+    void enforce_budget(const std::string* keep)
+    {
+        size_t budget = m_budget;
+        if(budget == 0 || m_bytes <= budget)
+        {
+            return;
+        }
+        std::unique_lock<std::mutex> evict_lock(m_evict_mutex);
+
+        while(m_bytes > budget)
+        {
+            // Pick the shard with the oldest victim
+            shard*   oldest    = nullptr;
+            uint64_t last_used = 0;
+            for(auto& sh : m_shards)
+            {
+                std::unique_lock<std::mutex> lock(sh.mutex);
+                auto                         iter = find_victim(sh, keep);
+                if(iter != sh.entries.end() && (!oldest || iter->last_used < last_used))
+                {
+                    oldest    = &sh;
+                    last_used = iter->last_used;
+                }
+            }
+            if(!oldest)
+            {
+                break;
+            }
+
+            std::unique_lock<std::mutex> lock(oldest->mutex);
+            // The shard could be changed after it was checked, release its current victim then
+            auto                         iter = find_victim(*oldest, keep);
+            if(iter == oldest->entries.end())
+            {
+                continue;
+            }
+            // Scaled copies are cheaper to restore, release them first
+            while(!iter->scaled.empty() && m_bytes > budget)
+            {
+                remove_scaled(*oldest, *iter);
+            }
+            if(m_bytes > budget)
+            {
+                m_bytes -= iter->bytes;
+                oldest->stats.evictions++;
+                oldest->index.erase(iter->url);
+                oldest->entries.erase(iter);
+            }
+        }
     }
 };
 
@@ -116,19 +116,11 @@ void container_cairo::draw_image(litehtml::uint_ptr hdc, const litehtml::backgro
     std::string img_url;
     make_url(url.c_str(), base_url.c_str(), img_url);
 
-    auto* bgbmp = get_image(img_url);
+    int   image_width  = litehtml::round_f(layer.origin_box.width);
+    int   image_height = litehtml::round_f(layer.origin_box.height);
+    auto* bgbmp        = get_scaled_image(img_url, image_width, image_height);
     if(bgbmp)
     {
-        int image_width  = litehtml::round_f(layer.origin_box.width);
-        int image_height = litehtml::round_f(layer.origin_box.height);
-
-        if(image_width != cairo_image_surface_get_width(bgbmp) || image_height != cairo_image_surface_get_height(bgbmp))
-        {
-            auto* new_img = scale_surface(bgbmp, image_width, image_height);
-            cairo_surface_destroy(bgbmp);
-            bgbmp = new_img;
-        }
-
         cairo_pattern_t* pattern = cairo_pattern_create_for_surface(bgbmp);
         cairo_matrix_t   flib_m;
         cairo_matrix_init_identity(&flib_m);
@@ -601,6 +593,18 @@ void container_cairo::rounded_rectangle(cairo_t* cr, const litehtml::position& p
     }
 }
 
+cairo_surface_t* container_cairo::get_scaled_image(const std::string& url, int width, int height)
+{
+    auto* img = get_image(url);
+    if(img && (width != cairo_image_surface_get_width(img) || height != cairo_image_surface_get_height(img)))
+    {
+        auto* new_img = scale_surface(img, width, height);
+        cairo_surface_destroy(img);
+        img = new_img;
+    }
+    return img;
+}
+
 cairo_surface_t* container_cairo::scale_surface(cairo_surface_t* surface, int width, int height)
 {
     int              s_width  = cairo_image_surface_get_width(surface);
@@ -64,6 +64,9 @@ class container_cairo : public litehtml::document_container
 
     virtual void             make_url(const char* url, const char* basepath, std::string& out);
     virtual cairo_surface_t* get_image(const std::string& url) = 0;
+    // Returns the image scaled to the width and height. The default implementation scales the image on each call,
+    // override it to cache the scaled images (see cairo_images_cache::get_scaled_image).
+    virtual cairo_surface_t* get_scaled_image(const std::string& url, int width, int height);
     virtual double           get_screen_dpi() const            = 0;
     virtual int              get_screen_width() const          = 0;
     virtual int              get_screen_height() const         = 0;
@@ -77,9 +80,10 @@ class container_cairo : public litehtml::document_container
                               litehtml::pixel_t height, const litehtml::web_color& color);
     virtual void rounded_rectangle(cairo_t* cr, const litehtml::position& pos, const litehtml::border_radiuses& radius);
 
-    void        clip_background_layer(cairo_t* cr, const litehtml::background_layer& layer);
-    void        apply_clip(cairo_t* cr);
-    static void set_color(cairo_t* cr, const litehtml::web_color& color)
+    void                    clip_background_layer(cairo_t* cr, const litehtml::background_layer& layer);
+    static cairo_surface_t* scale_surface(cairo_surface_t* surface, int width, int height);
+    void                    apply_clip(cairo_t* cr);
+    static void             set_color(cairo_t* cr, const litehtml::web_color& color)
     {
         cairo_set_source_rgba(cr, color.red / 255.0, color.green / 255.0, color.blue / 255.0, color.alpha / 255.0);
     }
@@ -88,7 +92,6 @@ class container_cairo : public litehtml::document_container
     static void add_path_arc(cairo_t* cr, double x, double y, double rx, double ry, double a1, double a2, bool neg);
     static void draw_pixbuf(cairo_t* cr, cairo_surface_t* bmp, litehtml::pixel_t x, litehtml::pixel_t y, int cx,
                             int cy);
-    static cairo_surface_t* scale_surface(cairo_surface_t* surface, int width, int height);
 };
 
 #endif
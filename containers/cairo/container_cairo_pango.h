@@ -42,6 +42,11 @@ class container_cairo_pango : public container_cairo
     litehtml::pixel_t  text_width(const char* text, litehtml::uint_ptr hFont) override;
     void draw_text(litehtml::uint_ptr hdc, const char* text, litehtml::uint_ptr hFont, litehtml::web_color color,
                    const litehtml::position& pos) override;
+    // Pango shapes the joined words the same way as separate words
+    bool draw_text_runs() const override
+    {
+        return true;
+    }
 
     virtual cairo_font_options_t* get_font_options()
     {
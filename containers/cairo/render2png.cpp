@@ -149,6 +149,18 @@ namespace html2png
             return image_surface;
         }
 
+        cairo_surface_t* get_scaled_image(const std::string& _url, int width, int height) override
+        {
+            // Load the image into the cache if it is not there yet
+            cairo_surface_t* image_surface = get_image(_url);
+            if(!image_surface)
+            {
+                return nullptr;
+            }
+            cairo_surface_destroy(image_surface);
+            return m_images.get_scaled_image(urlDecode(_url), width, height, scale_surface);
+        }
+
         double get_screen_dpi() const override
         {
             return m_converter->get_dpi();
@@ -46,6 +46,10 @@ class test_container : public document_container
     {
         return nullptr;
     }
+    bool creates_elements() const override
+    {
+        return false;
+    }
     void get_media_features(media_features& media) const override;
     void get_language(string& /*language*/, string& /*culture*/) const override {}
     void link(const document::ptr& /*doc*/, const element::ptr& /*el*/) override {}
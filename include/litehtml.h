@@ -3,8 +3,10 @@
 
 #include <litehtml/html.h>
 #include <litehtml/document.h>
+#include <litehtml/document_builder.h>
 #include <litehtml/html_tag.h>
 #include <litehtml/stylesheet.h>
+#include <litehtml/stylesheet_cache.h>
 #include <litehtml/element.h>
 #include <litehtml/utf8_strings.h>
 #include <litehtml/document_container.h>
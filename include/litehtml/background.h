@@ -92,6 +92,8 @@ namespace litehtml
         };
     };
 
+    class background_prepared_layer;
+
     class background
     {
       public:
@@ -155,6 +157,36 @@ namespace litehtml
         std::unique_ptr<background_layer::conic_gradient> get_conic_gradient_layer(int                     idx,
                                                                                    const background_layer& layer) const;
         void draw_layer(uint_ptr hdc, int idx, const background_layer& layer, document_container* container) const;
+        bool prepare_layer(int idx, position pos, const element* el, const std::shared_ptr<render_item>& ri,
+                           background_prepared_layer& prepared) const;
+    };
+
+    // Background layer with resolved boxes and prepared color, image or gradient.
+    // Boxes are relative to the position passed to background::prepare_layer(), so the prepared layer doesn't
+    // depend on the draw position and can be kept until the next layout.
+    class background_prepared_layer
+    {
+      public:
+        using vector = std::vector<background_prepared_layer>;
+
+        int                    idx  = 0;
+        background::layer_type type = background::type_none;
+        background_layer       layer;
+        // false if the size of the image is unknown yet, the layer must be prepared again
+        bool                   complete = true;
+        // origin box position the gradient points are calculated for
+        pointF                 gradient_origin;
+
+        std::unique_ptr<background_layer::color>           color;
+        std::unique_ptr<background_layer::image>           image;
+        std::unique_ptr<background_layer::linear_gradient> linear_gradient;
+        std::unique_ptr<background_layer::radial_gradient> radial_gradient;
+        std::unique_ptr<background_layer::conic_gradient>  conic_gradient;
+
+        // Returns the layer with boxes moved by x and y
+        background_layer get_layer(pixel_t x, pixel_t y) const;
+        // Draws the layer returned by get_layer(). Gradient points are moved to the origin box of the layer.
+        void draw(uint_ptr hdc, const background_layer& layer, document_container* container);
     };
 } // namespace litehtml
 
@@ -86,6 +86,11 @@ namespace litehtml
             bottom_left_y  -= mg.bottom;
             fix_values();
         }
+        bool is_zero() const
+        {
+            return top_left_x == 0_px && top_left_y == 0_px && top_right_x == 0_px && top_right_y == 0_px &&
+                   bottom_right_x == 0_px && bottom_right_y == 0_px && bottom_left_x == 0_px && bottom_left_y == 0_px;
+        }
         void fix_values()
         {
             top_left_x     = std::max<pixel_t>(top_left_x, 0_px);
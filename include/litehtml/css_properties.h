@@ -11,7 +11,10 @@
 namespace litehtml
 {
     class html_tag;
+    class style_index;
     class document;
+    class snapshot_writer;
+    class snapshot_reader;
 
     template <class CssT, class CompT> class css_property
     {
@@ -29,84 +32,145 @@ namespace litehtml
     // CSS Properties types
     using css_line_height_t = css_property<css_length, pixel_t>;
 
+    // The rarely set and the inherited properties are kept in the groups below. The groups are immutable and shared:
+    // the elements without the group properties in their style use the initial group or the group of the parent, so
+    // only the elements that set the properties allocate their own group. See css_properties::compute.
+
+    struct css_list_style
+    {
+        list_style_type     type     = list_style_type_none;
+        list_style_position position = list_style_position_outside;
+        std::string         image;
+        std::string         image_baseurl;
+    };
+
+    struct css_text_decoration
+    {
+        int                   line  = text_decoration_line_none;
+        text_decoration_style style = text_decoration_style_solid;
+        css_length            thickness;
+        web_color             color;
+        std::string           emphasis_style;
+        web_color             emphasis_color;
+        int                   emphasis_position = 0;
+    };
+
+    struct css_flex
+    {
+        float                grow   = 0;
+        float                shrink = 1;
+        css_length           basis;
+        flex_direction       direction       = flex_direction_row;
+        flex_wrap            wrap            = flex_wrap_nowrap;
+        flex_justify_content justify_content = flex_justify_content_flex_start;
+        flex_align_items     align_items     = flex_align_items_stretch;
+        flex_align_items     align_self      = flex_align_items_auto;
+        flex_align_content   align_content   = flex_align_content_stretch;
+        int                  order           = 0;
+    };
+
+    struct css_misc
+    {
+        std::string font_family;
+        std::string cursor;
+        std::string content;
+    };
+
+    struct css_font
+    {
+        uint_ptr          font = 0;
+        css_length        size = 0;
+        css_length        weight;
+        font_style        style = font_style_normal;
+        font_metrics      metrics;
+        css_line_height_t line_height{{}, 0_px};
+    };
+
     class css_properties
     {
       private:
-        element_position      m_el_position    = element_position_static;
-        text_align            m_text_align     = text_align_left;
-        overflow              m_overflow       = overflow_visible;
-        white_space           m_white_space    = white_space_normal;
-        style_display         m_display        = display_inline;
-        visibility            m_visibility     = visibility_visible;
-        appearance            m_appearance     = appearance_none;
-        box_sizing            m_box_sizing     = box_sizing_content_box;
-        css_length            m_z_index        = 0;
-        vertical_align        m_vertical_align = va_baseline;
-        element_float         m_float          = float_none;
-        element_clear         m_clear          = clear_none;
-        css_margins           m_css_margins;
-        css_margins           m_css_padding;
-        css_borders           m_css_borders;
-        css_length            m_css_width;
-        css_length            m_css_height;
-        css_length            m_css_min_width;
-        css_length            m_css_min_height;
-        css_length            m_css_max_width;
-        css_length            m_css_max_height;
-        css_offsets           m_css_offsets;
-        css_length            m_css_text_indent;
-        css_length            m_css_line_height = 0;
-        css_line_height_t     m_line_height{{}, 0_px};
-        list_style_type       m_list_style_type     = list_style_type_none;
-        list_style_position   m_list_style_position = list_style_position_outside;
-        std::string           m_list_style_image;
-        std::string           m_list_style_image_baseurl;
-        background            m_bg;
-        uint_ptr              m_font      = 0;
-        css_length            m_font_size = 0;
-        std::string           m_font_family;
-        css_length            m_font_weight;
-        font_style            m_font_style;
-        int                   m_text_decoration_line  = text_decoration_line_none;
-        text_decoration_style m_text_decoration_style = text_decoration_style_solid;
-        css_length            m_text_decoration_thickness;
-        web_color             m_text_decoration_color;
-        std::string           m_text_emphasis_style;
-        web_color             m_text_emphasis_color;
-        int                   m_text_emphasis_position = 0;
-        font_metrics          m_font_metrics;
-        text_transform        m_text_transform = text_transform_none;
-        web_color             m_color;
-        std::string           m_cursor;
-        std::string           m_content;
-        border_collapse       m_border_collapse = border_collapse_separate;
-        css_length            m_css_border_spacing_x;
-        css_length            m_css_border_spacing_y;
-
-        float                m_flex_grow   = 0;
-        float                m_flex_shrink = 1;
-        css_length           m_flex_basis;
-        flex_direction       m_flex_direction       = flex_direction_row;
-        flex_wrap            m_flex_wrap            = flex_wrap_nowrap;
-        flex_justify_content m_flex_justify_content = flex_justify_content_flex_start;
-        flex_align_items     m_flex_align_items     = flex_align_items_stretch;
-        flex_align_items     m_flex_align_self      = flex_align_items_auto;
-        flex_align_content   m_flex_align_content   = flex_align_content_stretch;
-
-        caption_side m_caption_side = caption_side_top;
-
-        int m_order = 0;
-
-        void      compute_font(const html_tag* el, const std::shared_ptr<document>& doc);
-        void      compute_background(const html_tag* el, const std::shared_ptr<document>& doc);
-        void      compute_flex(const html_tag* el, const std::shared_ptr<document>& doc);
-        web_color get_color_property(const html_tag* el, string_id name, bool inherited, web_color default_value,
-                                     uint_ptr member_offset) const;
+        // Layout properties
+        element_position  m_el_position    = element_position_static;
+        text_align        m_text_align     = text_align_left;
+        overflow          m_overflow       = overflow_visible;
+        white_space       m_white_space    = white_space_normal;
+        style_display     m_display        = display_inline;
+        visibility        m_visibility     = visibility_visible;
+        appearance        m_appearance     = appearance_none;
+        box_sizing        m_box_sizing     = box_sizing_content_box;
+        vertical_align    m_vertical_align = va_baseline;
+        element_float     m_float          = float_none;
+        element_clear     m_clear          = clear_none;
+        text_transform    m_text_transform = text_transform_none;
+        border_collapse   m_border_collapse = border_collapse_separate;
+        caption_side      m_caption_side    = caption_side_top;
+        css_length        m_z_index         = 0;
+        css_margins       m_css_margins;
+        css_margins       m_css_padding;
+        css_borders       m_css_borders;
+        css_length        m_css_width;
+        css_length        m_css_height;
+        css_length        m_css_min_width;
+        css_length        m_css_min_height;
+        css_length        m_css_max_width;
+        css_length        m_css_max_height;
+        css_offsets       m_css_offsets;
+        css_length        m_css_text_indent;
+        css_length        m_css_border_spacing_x;
+        css_length        m_css_border_spacing_y;
+        web_color         m_color;
+
+        // Property groups, never null
+        std::shared_ptr<const background>          m_bg              = initial_group<background>();
+        std::shared_ptr<const css_list_style>      m_list_style      = initial_group<css_list_style>();
+        std::shared_ptr<const css_text_decoration> m_text_decoration = initial_group<css_text_decoration>();
+        std::shared_ptr<const css_flex>            m_flex            = initial_group<css_flex>();
+        std::shared_ptr<const css_misc>            m_misc            = initial_group<css_misc>();
+        std::shared_ptr<const css_font>            m_font            = initial_group<css_font>();
+
+        template <class Group> static const std::shared_ptr<const Group>& initial_group()
+        {
+            static const std::shared_ptr<const Group> group = std::make_shared<const Group>();
+            return group;
+        }
+        // Replaces the group with its own copy for changing. The group is always copied: a group can be shared with
+        // other elements, the background cache and the snapshot writer, and use_count() is not reliable across
+        // threads.
+        template <class Group> static Group& unshare(std::shared_ptr<const Group>& group)
+        {
+            auto   copy = std::make_shared<Group>(*group);
+            Group& ret  = *copy;
+            group       = std::move(copy);
+            return ret;
+        }
+
+        void      compute_font(const html_tag* el, const style_index& declared, const std::shared_ptr<document>& doc);
+        void      create_font(css_font& font, const std::shared_ptr<document>& doc) const;
+        void      compute_misc(const html_tag* el, const style_index& declared, const std::shared_ptr<document>& doc);
+        void      compute_text_decoration(const html_tag* el, const style_index& declared);
+        void      compute_list_style(const html_tag* el, const style_index& declared,
+                                     const std::shared_ptr<document>& doc);
+        void      compute_background(const html_tag* el, const style_index& declared,
+                                     const std::shared_ptr<document>& doc);
+        void      compute_flex(const html_tag* el, const style_index& declared, const std::shared_ptr<document>& doc);
+        template <class... Member>
+        web_color get_color_property(const html_tag* el, const style_index& declared, string_id name, bool inherited,
+                                     web_color default_value, Member... member) const;
         void      snap_border_width(css_length& width, const std::shared_ptr<document>& doc);
+        // Calls fn for every property outside of the groups, for writing and reading the snapshots alike
+        template <class Props, class Fn> static void for_each_value(Props& props, Fn&& fn);
 
       public:
-        void compute(const html_tag* el, const std::shared_ptr<document>& doc);
-
+        // declared is the index of the element style, see html_tag::compute_styles()
+        void compute(const html_tag* el, const style_index& declared, const std::shared_ptr<document>& doc);
+        // Writes the computed properties into the document snapshot, see document::serialize()
+        void write(snapshot_writer& out) const;
+        // Reads the properties written by write(). The values are taken as computed, only the fonts are created again
+        // from their descriptions and the images are loaded like compute() does.
+        bool read(snapshot_reader& reader, const std::shared_ptr<document>& doc);
+
+        // Adds the properties and the property groups not counted yet to usage.styles
+        void get_memory_usage(memory_usage_info& usage) const;
         std::vector<std::tuple<std::string, std::string>> dump_get_attrs();
 
         element_position get_position() const;
@@ -181,6 +245,9 @@ namespace litehtml
         const css_line_height_t& line_height() const;
         css_line_height_t&       line_height_w();
 
+        // Shares the font, its metrics and the line height of the parent, for the elements without own style
+        void inherit_font(const css_properties& parent);
+
         list_style_type get_list_style_type() const;
         void            set_list_style_type(list_style_type mListStyleType);
 
@@ -193,8 +260,9 @@ namespace litehtml
         const std::string& get_list_style_image_baseurl() const;
         void               set_list_style_image_baseurl(const std::string& url);
 
-        const background& get_bg() const;
-        void              set_bg(const background& mBg);
+        const background&                        get_bg() const;
+        const std::shared_ptr<const background>& get_bg_group() const;
+        void                                     set_bg(const background& mBg);
 
         pixel_t get_font_size() const;
         void    set_font_size(pixel_t mFontSize);
@@ -252,6 +320,10 @@ namespace litehtml
         int                get_text_emphasis_position() const;
     };
 
+    // css_properties is a part of every element, including the text ones. Keep the rarely used properties in the
+    // groups when adding new ones.
+    static_assert(sizeof(void*) != 8 || sizeof(css_properties) <= 480, "css_properties became larger");
+
     inline element_position css_properties::get_position() const
     {
         return m_el_position;
@@ -484,90 +556,100 @@ namespace litehtml
 
     inline const css_line_height_t& css_properties::line_height() const
     {
-        return m_line_height;
+        return m_font->line_height;
     }
 
     inline css_line_height_t& css_properties::line_height_w()
     {
-        return m_line_height;
+        return unshare(m_font).line_height;
+    }
+
+    inline void css_properties::inherit_font(const css_properties& parent)
+    {
+        m_font = parent.m_font;
     }
 
     inline list_style_type css_properties::get_list_style_type() const
     {
-        return m_list_style_type;
+        return m_list_style->type;
     }
 
     inline void css_properties::set_list_style_type(list_style_type mListStyleType)
     {
-        m_list_style_type = mListStyleType;
+        unshare(m_list_style).type = mListStyleType;
     }
 
     inline list_style_position css_properties::get_list_style_position() const
     {
-        return m_list_style_position;
+        return m_list_style->position;
     }
 
     inline void css_properties::set_list_style_position(list_style_position mListStylePosition)
     {
-        m_list_style_position = mListStylePosition;
+        unshare(m_list_style).position = mListStylePosition;
     }
 
     inline const std::string& css_properties::get_list_style_image() const
     {
-        return m_list_style_image;
+        return m_list_style->image;
     }
     inline void css_properties::set_list_style_image(const std::string& url)
     {
-        m_list_style_image = url;
+        unshare(m_list_style).image = url;
     }
 
     inline const std::string& css_properties::get_list_style_image_baseurl() const
     {
-        return m_list_style_image_baseurl;
+        return m_list_style->image_baseurl;
     }
     inline void css_properties::set_list_style_image_baseurl(const std::string& url)
     {
-        m_list_style_image_baseurl = url;
+        unshare(m_list_style).image_baseurl = url;
     }
 
     inline const background& css_properties::get_bg() const
+    {
+        return *m_bg;
+    }
+
+    inline const std::shared_ptr<const background>& css_properties::get_bg_group() const
     {
         return m_bg;
     }
 
     inline void css_properties::set_bg(const background& mBg)
     {
-        m_bg = mBg;
+        m_bg = std::make_shared<background>(mBg);
     }
 
     inline pixel_t css_properties::get_font_size() const
     {
-        return {m_font_size.val()};
+        return {m_font->size.val()};
     }
 
     inline void css_properties::set_font_size(pixel_t mFontSize)
     {
-        m_font_size = mFontSize.value();
+        unshare(m_font).size = mFontSize.value();
     }
 
     inline uint_ptr css_properties::get_font() const
     {
-        return m_font;
+        return m_font->font;
     }
 
     inline void css_properties::set_font(uint_ptr mFont)
     {
-        m_font = mFont;
+        unshare(m_font).font = mFont;
     }
 
     inline const font_metrics& css_properties::get_font_metrics() const
     {
-        return m_font_metrics;
+        return m_font->metrics;
     }
 
     inline void css_properties::set_font_metrics(const font_metrics& mFontMetrics)
     {
-        m_font_metrics = mFontMetrics;
+        unshare(m_font).metrics = mFontMetrics;
     }
 
     inline text_transform css_properties::get_text_transform() const
@@ -591,20 +673,20 @@ namespace litehtml
 
     inline const std::string& css_properties::get_cursor() const
     {
-        return m_cursor;
+        return m_misc->cursor;
     }
     inline void css_properties::set_cursor(const std::string& cursor)
     {
-        m_cursor = cursor;
+        unshare(m_misc).cursor = cursor;
     }
 
     inline const std::string& css_properties::get_content() const
     {
-        return m_content;
+        return m_misc->content;
     }
     inline void css_properties::set_content(const std::string& content)
     {
-        m_content = content;
+        unshare(m_misc).content = content;
     }
 
     inline border_collapse css_properties::get_border_collapse() const
@@ -639,47 +721,47 @@ namespace litehtml
 
     inline float css_properties::get_flex_grow() const
     {
-        return m_flex_grow;
+        return m_flex->grow;
     }
 
     inline float css_properties::get_flex_shrink() const
     {
-        return m_flex_shrink;
+        return m_flex->shrink;
     }
 
     inline const css_length& css_properties::get_flex_basis() const
     {
-        return m_flex_basis;
+        return m_flex->basis;
     }
 
     inline flex_direction css_properties::get_flex_direction() const
     {
-        return m_flex_direction;
+        return m_flex->direction;
     }
 
     inline flex_wrap css_properties::get_flex_wrap() const
     {
-        return m_flex_wrap;
+        return m_flex->wrap;
     }
 
     inline flex_justify_content css_properties::get_flex_justify_content() const
     {
-        return m_flex_justify_content;
+        return m_flex->justify_content;
     }
 
     inline flex_align_items css_properties::get_flex_align_items() const
     {
-        return m_flex_align_items;
+        return m_flex->align_items;
     }
 
     inline flex_align_items css_properties::get_flex_align_self() const
     {
-        return m_flex_align_self;
+        return m_flex->align_self;
     }
 
     inline flex_align_content css_properties::get_flex_align_content() const
     {
-        return m_flex_align_content;
+        return m_flex->align_content;
     }
 
     inline caption_side css_properties::get_caption_side() const
@@ -693,47 +775,47 @@ namespace litehtml
 
     inline int css_properties::get_order() const
     {
-        return m_order;
+        return m_flex->order;
     }
 
     inline void css_properties::set_order(int order)
     {
-        m_order = order;
+        unshare(m_flex).order = order;
     }
 
     inline int css_properties::get_text_decoration_line() const
     {
-        return m_text_decoration_line;
+        return m_text_decoration->line;
     }
 
     inline text_decoration_style css_properties::get_text_decoration_style() const
     {
-        return m_text_decoration_style;
+        return m_text_decoration->style;
     }
 
     inline const css_length& css_properties::get_text_decoration_thickness() const
     {
-        return m_text_decoration_thickness;
+        return m_text_decoration->thickness;
     }
 
     inline const web_color& css_properties::get_text_decoration_color() const
     {
-        return m_text_decoration_color;
+        return m_text_decoration->color;
     }
 
     inline const std::string& css_properties::get_text_emphasis_style() const
     {
-        return m_text_emphasis_style;
+        return m_text_decoration->emphasis_style;
     }
 
     inline web_color css_properties::get_text_emphasis_color() const
     {
-        return m_text_emphasis_color;
+        return m_text_decoration->emphasis_color;
     }
 
     inline int css_properties::get_text_emphasis_position() const
     {
-        return m_text_emphasis_position;
+        return m_text_decoration->emphasis_position;
     }
 } // namespace litehtml
 
@@ -252,11 +252,11 @@ namespace litehtml
 
     //////////////////////////////////////////////////////////////////////////
 
+    // The selector matched by the element, kept by value in the element to check later if it still applies
     class used_selector
     {
       public:
-        using ptr    = std::unique_ptr<used_selector>;
-        using vector = std::vector<used_selector::ptr>;
+        using vector = std::vector<used_selector>;
 
         css_selector::ptr m_selector;
         bool              m_used;
@@ -85,8 +85,8 @@ namespace litehtml
         {
         }
 
-        css_token(css_token_type type, const std::string& str) :
-            m_str(str),
+        css_token(css_token_type type, std::string str) :
+            m_str(std::move(str)),
             type(type),
             n()
         {
@@ -120,7 +120,31 @@ namespace litehtml
             }
         }
 
-        css_token& operator=(const css_token& token) = default;
+        // Tokens are moved a lot while parsing, the move doesn't copy the strings and the nested values
+        css_token(css_token&& token) noexcept :
+            m_str(std::move(token.m_str)),
+            type(token.type),
+            value(std::move(token.value)),
+            repr(std::move(token.repr))
+        {
+            switch(type)
+            {
+            case HASH:
+                hash_type = token.hash_type;
+                break;
+
+            case NUMBER:
+            case PERCENTAGE:
+            case DIMENSION:
+                n = token.n;
+                break;
+
+            default:;
+            }
+        }
+
+        css_token& operator=(const css_token& token)     = default;
+        css_token& operator=(css_token&& token) noexcept = default;
 
         bool is_component_value() const
         {
@@ -183,8 +207,8 @@ namespace litehtml
     class css_tokenizer
     {
       public:
-        css_tokenizer(const std::string& input) :
-            str(input)
+        css_tokenizer(std::string input) :
+            str(std::move(input))
         {
         }
 
@@ -240,9 +264,9 @@ namespace litehtml
     };
 
     void                    css_parse_error(const std::string& msg);
-    inline css_token_vector tokenize(const std::string& str)
+    inline css_token_vector tokenize(std::string str)
     {
-        return css_tokenizer(str).tokenize();
+        return css_tokenizer(std::move(str)).tokenize();
     }
 
 } // namespace litehtml
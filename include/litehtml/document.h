@@ -5,9 +5,11 @@
 #include "encodings.h"
 #include "font_description.h"
 #include "master_css.h"
+#include "node_arena.h"
 #include "types.h"
 
 #include <functional>
+#include <unordered_map>
 #include <vector>
 
 using GumboOutput = struct GumboInternalOutput;
@@ -53,6 +55,7 @@ namespace litehtml
         using weak_ptr = std::weak_ptr<document>;
 
       private:
+        std::shared_ptr<node_arena>             m_arena; // the nodes, null without LITEHTML_NODE_ARENA; see make_node
         std::shared_ptr<element>                m_root;
         std::shared_ptr<render_item>            m_root_render;
         document_container*                     m_container;
@@ -69,12 +72,22 @@ namespace litehtml
         std::list<std::shared_ptr<render_item>> m_tabular_elements;
         media_query_list_list::vector           m_media_lists;
         media_features                          m_media;
+        media_breakpoints                       m_media_breakpoints; // of m_media_lists, collected on demand
+        bool                                    m_media_breakpoints_valid = false;
         std::string                             m_lang;
         std::string                             m_culture;
-        std::string                             m_text;
         document_mode                           m_mode      = no_quirks_mode;
         bool                                    m_finalized = false;
 
+        // Parsed values of the properties with var() by the property name and the substituted value. Elements
+        // usually get the same variables, so the value is parsed once, see parse_substituted_property.
+        std::unordered_map<std::string, style> m_substituted_properties;
+
+        std::vector<std::shared_ptr<render_item>> m_layers;
+        bool                                      m_layers_enabled = false;
+        bool                                      m_layered_draw   = false;
+        const render_item*                        m_draw_layer     = nullptr;
+
       public:
         document(document_container* objContainer);
         virtual ~document();
@@ -87,9 +100,35 @@ namespace litehtml
         {
             return m_mode;
         }
+        // The memory pool of the document nodes, nullptr if the nodes are allocated on the heap
+        const std::shared_ptr<node_arena>& arena() const
+        {
+            return m_arena;
+        }
         uint_ptr  get_font(const font_description& descr, font_metrics* fm);
         pixel_t   render(pixel_t max_width, render_type rt = render_all);
         void      draw(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip);
+        // Enables splitting the document into layers. See get_layers() and draw_layer().
+        void enable_layers(bool enable);
+        bool layers_enabled() const
+        {
+            return m_layers_enabled;
+        }
+        // Returns the layers of the rendered document. The first layer is always the document layer.
+        // The fixed elements with negative z-index and the scroll boxes overlapped by positioned elements are not
+        // layers, they are drawn with the document.
+        void get_layers(layer_info::vector& layers) const;
+        // Draws the single layer. Content of the other layers is excluded.
+        // The document layer is drawn like draw() does. Fixed layers are drawn relative to the viewport and scroll
+        // layers are drawn relative to the scroll box content without the scroll shift. x and y shift the layer.
+        void draw_layer(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip, uint_ptr layer_id);
+        // Returns true if the render item starts a layer that is excluded from the current draw_layer() call
+        bool is_layer_hidden(const render_item* ri) const;
+        // Returns true if the render item starts the layer drawn by the current draw_layer() call
+        bool is_layer_drawn(const render_item* ri) const
+        {
+            return m_layered_draw && ri == m_draw_layer;
+        }
         web_color get_def_color() const
         {
             return m_def_color;
@@ -126,14 +165,37 @@ namespace litehtml
             return m_over_element;
         }
 
+        // Returns the style holding the parsed property, whose var() functions are substituted with the value
+        const style& parse_substituted_property(string_id name, const css_token_vector& value, bool important);
+
         void append_children_from_string(element& parent, const char* str, bool replace_existing);
         void dump(dumper& cout);
+        // Returns the approximate memory used by the document
+        memory_usage_info memory_usage() const;
+
+        // Returns the number of documents parsed twice, because <meta> in <head> changed the tentative encoding.
+        // The encoding prescan finds such <meta> before parsing, so it happens only when the prescan can't see it.
+        static size_t reparse_count();
 
         // see doc/document_createFromString.txt
         static document::ptr createFromString(const estring& str, document_container* container,
                                               const std::string& master_styles = litehtml::master_css,
                                               const std::string& user_styles   = {});
 
+        // Writes the element tree with the computed properties of the elements into a compact binary snapshot, see
+        // deserialize(). The fonts are stored as their descriptions.
+        void serialize(std::string& out) const;
+        // Creates the document from the snapshot written by serialize() of the same library build. The data can be a
+        // memory-mapped file, it is not needed after the call. The HTML and CSS parsing and the style computation are
+        // skipped: the fonts are created by the container from their descriptions, the images are loaded, and the
+        // render tree is built for render(). The stylesheets are not kept, so the styles don't change with :hover,
+        // :active or the media features, and the elements added by append_children_from_string() get their style
+        // attributes only. There are no master and user styles parameters: the snapshot has the computed styles.
+        // Returns nullptr if the snapshot is truncated, invalid or nested deeper than 1024 elements. The structure of
+        // the data, the keyword values of the properties and the finiteness of the numbers are checked, so any data can
+        // be passed; the finite lengths and the colors are taken as they are.
+        static document::ptr deserialize(const char* data, size_t size, document_container* container);
+
         // The mode must be set before any element is created, because it is used in html_tag::set_attr.
         void set_document_mode(document_mode mode);
         // Finish a document whose element tree was built by the caller with create_element() and
@@ -146,10 +208,16 @@ namespace litehtml
 
       private:
         uint_ptr add_font(const font_description& descr, font_metrics* fm);
-
-        GumboOutput* parse_html(estring str);
-        void         create_node(void* gnode, elements_list& elements, bool parseTextNode, bool process_root);
-        bool         update_media_lists(const media_features& features);
+        // The finalization of deserialize(): the elements have their properties already
+        void     finalize_from_snapshot(const std::shared_ptr<element>& root);
+
+        GumboOutput* parse_html(estring str, std::string& text);
+        void         create_node(void* gnode, const std::shared_ptr<element>& parent, elements_list& elements,
+                                 bool parseTextNode, bool process_root);
+        // Applies the features to the media lists, the lists whose results changed are added to changed
+        bool         update_media_lists(const media_features&        features,
+                                        media_query_list_list::vector* changed = nullptr);
+        void         update_layers();
         void         fix_tables_layout();
         void fix_table_children(const std::shared_ptr<render_item>& el_ptr, style_display disp, const char* disp_str);
         void fix_table_parent(const std::shared_ptr<render_item>& el_ptr, style_display disp, const char* disp_str);
@@ -0,0 +1,75 @@
+#ifndef LITEHTML_DOCUMENT_BUILDER_H
+#define LITEHTML_DOCUMENT_BUILDER_H
+
+#include "document.h"
+
+namespace litehtml
+{
+    // Collects the HTML source arriving in chunks (e.g. from network) and creates the document from it.
+    //
+    // The encoding is sniffed as soon as enough bytes are received (see encoding_sniffed()).
+    // create_partial_document() creates the document from the data received so far, so the page can be rendered
+    // and drawn before the download is complete. The partial document is a separate document, it is replaced by
+    // the next partial one or by the document returned from finish(). The final document is the same as
+    // document::createFromString() creates from the complete source.
+    class document_builder
+    {
+        document_container* m_container;
+        std::string         m_master_styles;
+        std::string         m_user_styles;
+        estring             m_source;
+        encoding            m_encoding         = encoding::null;
+        confidence          m_confidence       = confidence::tentative;
+        bool                m_encoding_sniffed = false;
+        size_t              m_partial_size     = 0;
+
+      public:
+        // encoding is the encoding from the transport layer (e.g. HTTP Content-Type header), if it is known
+        explicit document_builder(document_container* container, const std::string& master_styles = litehtml::master_css,
+                                  const std::string& user_styles = {}, encoding enc = encoding::null);
+
+        void append(const char* data, size_t len);
+        void append(const std::string& data)
+        {
+            append(data.data(), data.size());
+        }
+
+        // The received data
+        const std::string& source() const
+        {
+            return m_source;
+        }
+        // Size of the received data
+        size_t size() const
+        {
+            return m_source.size();
+        }
+        // Size of the data used by the last partial document
+        size_t partial_size() const
+        {
+            return m_partial_size;
+        }
+        // Returns true if the encoding of the source is determined. It is sniffed from the first
+        // encoding_sniffing_size bytes, the same ones document::createFromString examines.
+        bool encoding_sniffed() const
+        {
+            return m_encoding_sniffed;
+        }
+        // Returns the sniffed encoding, or encoding::null if it is not determined yet
+        encoding get_encoding() const
+        {
+            return m_encoding;
+        }
+
+        // Creates the document from the data received so far. The data is cut after the last complete tag.
+        // Returns nullptr if there is no new complete tag since the previous partial document.
+        document::ptr create_partial_document();
+        // Creates the final document from all received data
+        document::ptr finish();
+
+      private:
+        void sniff_encoding(bool complete);
+    };
+} // namespace litehtml
+
+#endif // LITEHTML_DOCUMENT_BUILDER_H
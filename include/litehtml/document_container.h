@@ -74,6 +74,12 @@ namespace litehtml
         virtual void get_viewport(litehtml::position& viewport) const                                     = 0;
         virtual litehtml::element::ptr create_element(const char* tag_name, const litehtml::string_map& attributes,
                                                       const std::shared_ptr<litehtml::document>& doc)     = 0;
+        // Return false if create_element() always returns nullptr. The parser doesn't collect the attributes of
+        // every element into a string_map for create_element() then.
+        virtual bool creates_elements() const
+        {
+            return true;
+        }
 
         virtual void        get_media_features(litehtml::media_features& media) const       = 0;
         virtual void        get_language(std::string& language, std::string& culture) const = 0;
@@ -83,6 +89,12 @@ namespace litehtml
         }
         virtual void split_text(const char* text, const std::function<void(const char*)>& on_word,
                                 const std::function<void(const char*)>& on_space);
+        // Return true to receive adjacent words of the same line, font and color in one draw_text() call.
+        // The container must place the glyphs of the joined text the same way text_width() measures the words.
+        virtual bool draw_text_runs() const
+        {
+            return false;
+        }
 
       protected:
         virtual ~document_container() = default;
@@ -11,6 +11,7 @@ namespace litehtml
         explicit el_base(const std::shared_ptr<litehtml::document>& doc);
 
         void parse_attributes() override;
+        void restore_state() override;
     };
 } // namespace litehtml
 
@@ -14,6 +14,7 @@ namespace litehtml
 
         void get_text(std::string& text) const override;
         void set_data(const char* data) override;
+        void get_memory_usage(memory_usage_info& usage) const override;
     };
 } // namespace litehtml
 
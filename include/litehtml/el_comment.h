@@ -15,6 +15,7 @@ namespace litehtml
         bool                         is_comment() const override;
         void                         get_text(std::string& text) const override;
         void                         set_data(const char* data) override;
+        void                         get_memory_usage(memory_usage_info& usage) const override;
         std::shared_ptr<render_item> create_render_item(const std::shared_ptr<render_item>& /*parent_ri*/) override
         {
             // Comments are not rendered
@@ -18,6 +18,7 @@ namespace litehtml
         bool is_replaced() const override;
         void parse_attributes() override;
         void compute_styles(bool recursive = true) override;
+        void restore_state() override;
         void draw(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
                   const std::shared_ptr<render_item>& ri) override;
         void get_content_size(size& sz, pixel_t max_width) override;
@@ -27,6 +28,7 @@ namespace litehtml
         std::shared_ptr<render_item> create_render_item(const std::shared_ptr<render_item>& parent_ri) override;
 
       private:
+        void load_image();
         //		pixel_t calc_max_height(pixel_t image_height);
     };
 } // namespace litehtml
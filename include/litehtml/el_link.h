@@ -12,6 +12,7 @@ namespace litehtml
 
       protected:
         void parse_attributes() override;
+        void restore_state() override;
     };
 } // namespace litehtml
 
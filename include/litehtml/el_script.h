@@ -16,6 +16,7 @@ namespace litehtml
         bool        appendChild(const ptr& el) override;
         string_id   tag() const override;
         const char* get_tagName() const override;
+        void        get_memory_usage(memory_usage_info& usage) const override;
     };
 } // namespace litehtml
 
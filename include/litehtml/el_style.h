@@ -17,6 +17,8 @@ namespace litehtml
         void        compute_styles(bool recursive) override;
         string_id   tag() const override;
         const char* get_tagName() const override;
+        // The stylesheet text. get_text() is not overridden, the text is not a part of the document text.
+        void get_style_text(std::string& text) const;
     };
 } // namespace litehtml
 
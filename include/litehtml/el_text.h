@@ -6,6 +6,26 @@
 
 namespace litehtml
 {
+    // Adjacent words of the same line with the same font and color drawn with one draw_text() call.
+    // Used if document_container::draw_text_runs() returns true.
+    class text_run
+    {
+        std::string m_text;
+        position    m_pos;
+        uint_ptr    m_font = 0;
+        web_color   m_color;
+
+      public:
+        bool empty() const
+        {
+            return m_font == 0;
+        }
+        // Appends the text to the run. Returns false if the text doesn't continue the run.
+        bool add(const std::string& text, uint_ptr font, const web_color& color, const position& pos);
+        // Draws the collected text and clears the run
+        void flush(uint_ptr hdc, const position* clip, document_container* container);
+    };
+
     class el_text : public element
     {
       protected:
@@ -27,9 +47,12 @@ namespace litehtml
 
         void        draw(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
                          const std::shared_ptr<render_item>& ri) override;
+        // Adds the text into the run instead of drawing. Returns false if the text must be drawn separately.
+        bool        add_to_run(text_run& run, pixel_t x, pixel_t y, const std::shared_ptr<render_item>& ri) const;
         std::string dump_get_name() override;
 
         std::vector<std::tuple<std::string, std::string>> dump_get_attrs() override;
+        void                                              get_memory_usage(memory_usage_info& usage) const override;
 
       protected:
         void get_content_size(size& sz, pixel_t max_width) override;
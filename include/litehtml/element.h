@@ -4,6 +4,8 @@
 #include "types.h"
 #include "css_properties.h"
 #include "stylesheet.h"
+#include "node_arena.h"
+#include <cassert>
 #include <functional>
 #include <list>
 #include <memory>
@@ -28,12 +30,14 @@ namespace litehtml
         using weak_ptr  = std::weak_ptr<element>;
 
       protected:
-        std::weak_ptr<element>                m_parent;
-        std::weak_ptr<document>               m_doc;
-        elements_list                         m_children;
-        css_properties                        m_css;
-        std::list<std::weak_ptr<render_item>> m_renders;
-        used_selector::vector                 m_used_styles;
+        std::weak_ptr<element>                  m_parent;
+        std::weak_ptr<document>                 m_doc;
+        element*                                m_parent_ptr = nullptr; // m_parent without reference counting
+        document*                               m_doc_ptr    = nullptr; // m_doc without reference counting
+        elements_list                           m_children;
+        css_properties                          m_css;
+        std::vector<std::weak_ptr<render_item>> m_renders;
+        used_selector::vector                   m_used_styles;
 
         virtual void select_all(const css_selector& selector, elements_list& res);
         element::ptr _add_before_after(int type, const style& style);
@@ -43,7 +47,7 @@ namespace litehtml
 
       public:
         explicit element(const std::shared_ptr<document>& doc);
-        virtual ~element() = default;
+        virtual ~element();
 
         const css_properties& css() const;
         css_properties&       css_w();
@@ -63,11 +67,19 @@ namespace litehtml
         bool         is_root() const;
         element::ptr parent() const;
         void         parent(const element::ptr& par);
+        // The parent and the document without the reference counting, for the internal hot paths. The parent owns
+        // its children and the document owns the tree, so the pointers are valid while the element is in the tree.
+        // The destroyed element resets the parent of its children, so an element kept by the application after its
+        // parent was released has no parent, like with parent().
+        element*  parent_ptr() const;
+        document* document_ptr() const;
         // returns true for elements inside a table (but outside cells) that don't participate in table rendering
         bool is_table_skip() const;
 
-        std::shared_ptr<document>                  get_document() const;
-        const std::list<std::shared_ptr<element>>& children() const;
+        std::shared_ptr<document>   get_document() const;
+        // Returns the memory pool for the new nodes of the document, see make_node
+        std::shared_ptr<node_arena> get_arena() const;
+        const elements_list&        children() const;
 
         std::shared_ptr<render_item> get_render_item();
 
@@ -89,8 +101,11 @@ namespace litehtml
 
         virtual void        set_attr(const char* name, const char* val);
         virtual const char* get_attr(const char* name, const char* def = nullptr) const;
+        virtual const char* get_attr(string_id name, const char* def = nullptr) const;
         virtual void        apply_stylesheet(const litehtml::css& stylesheet);
         virtual void        refresh_styles();
+        // Restyles the subtrees of the elements using the selectors from the changed media lists
+        virtual void        refresh_media_styles(const media_query_list_list::vector& changed);
         virtual bool        is_white_space() const;
         virtual bool        is_space() const;
         virtual bool        is_comment() const;
@@ -107,6 +122,9 @@ namespace litehtml
         virtual bool set_class(const char* pclass, bool add);
         virtual bool is_replaced() const;
         virtual void compute_styles(bool recursive = true);
+        // Restores the element state that parse_attributes() and compute_styles() keep outside of the properties, see
+        // document::deserialize(). The snapshot has the properties of the tags only, the other elements compute them.
+        virtual void restore_state();
         virtual void draw(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
                           const std::shared_ptr<render_item>& ri);
         virtual void draw_background(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
@@ -137,6 +155,8 @@ namespace litehtml
         virtual std::string                                       dump_get_name();
         virtual std::vector<std::tuple<std::string, std::string>> dump_get_attrs();
         void                                                      dump(litehtml::dumper& cout);
+        // Adds the memory used by the element and its children
+        virtual void get_memory_usage(memory_usage_info& usage) const;
 
         std::tuple<element::ptr, element::ptr, element::ptr> split_inlines();
         virtual std::shared_ptr<render_item> create_render_item(const std::shared_ptr<render_item>& parent_ri);
@@ -190,7 +210,20 @@ namespace litehtml
 
     inline void litehtml::element::parent(const element::ptr& par)
     {
-        m_parent = par;
+        m_parent     = par;
+        m_parent_ptr = par.get();
+    }
+
+    inline element* element::parent_ptr() const
+    {
+        assert(!m_parent_ptr || !m_parent.expired());
+        return m_parent_ptr;
+    }
+
+    inline document* element::document_ptr() const
+    {
+        assert(!m_doc_ptr || !m_doc.expired());
+        return m_doc_ptr;
     }
 
     inline bool litehtml::element::is_positioned() const
@@ -224,7 +257,7 @@ namespace litehtml
                css().get_display() == display_table || css().get_display() == display_list_item;
     }
 
-    inline const std::list<std::shared_ptr<element>>& element::children() const
+    inline const elements_list& element::children() const
     {
         return m_children;
     }
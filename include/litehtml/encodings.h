@@ -87,6 +87,9 @@ namespace litehtml
         }
     };
 
+    // encoding_sniffing_algorithm examines no more than this number of bytes of the source
+    const size_t encoding_sniffing_size = 64 * 1024;
+
     encoding bom_sniff(const std::string& str);
     void     encoding_sniffing_algorithm(estring& str);
 
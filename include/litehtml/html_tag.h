@@ -11,6 +11,24 @@
 
 namespace litehtml
 {
+    struct background_cache_item;
+
+    // Attribute of the element, the name is lowercase
+    // The attribute names known to string_id are kept as ids. The other names (data-*, aria-*) are kept as lowercase
+    // strings, so the attributes of the pages don't grow the process-wide string_id table, which is never freed.
+    struct html_attribute
+    {
+        using vector = std::vector<html_attribute>;
+
+        string_id   name = empty_id;
+        std::string value;
+        std::string unknown_name; // the name if it is not known to string_id, name is empty_id then
+
+        const std::string& get_name() const
+        {
+            return name == empty_id ? unknown_name : _s(name);
+        }
+    };
 
     class html_tag : public element
     {
@@ -25,14 +43,22 @@ namespace litehtml
       protected:
         string_id              m_tag = empty_id;
         string_id              m_id  = empty_id;
-        string_vector          m_str_classes;
-        std::vector<string_id> m_classes;
+        std::vector<string_id> m_classes;        // sorted, without duplicates
+        uint64_t               m_class_mask = 0; // class_bit() of all classes
         style                  m_style;
-        string_map             m_attrs;
+        html_attribute::vector m_attrs;
         std::vector<string_id> m_pseudo_classes;
 
         void select_all(const css_selector& selector, elements_list& res) override;
 
+        template <class Type>
+        const Type& computed_property(const property_value& value, bool inherited, const Type& default_value,
+                                      uint_ptr css_properties_member_offset) const;
+        template <class Type, class Group>
+        const Type& computed_property(const property_value& value, bool inherited, const Type& default_value,
+                                      std::shared_ptr<const Group> css_properties::* group,
+                                      uint_ptr group_member_offset) const;
+
       public:
         explicit html_tag(const std::shared_ptr<document>& doc);
         // constructor for anonymous wrapper boxes
@@ -46,19 +72,36 @@ namespace litehtml
         const char*                   get_tagName() const override;
         void                          set_tagName(const char* tag) override;
         void                          set_data(const char* data) override;
+        // Class ids sorted by value, the names in their original case are in the class attribute
         const std::vector<string_id>& classes() const
         {
             return m_classes;
         }
-        const string_vector& str_classes() const
+        bool has_class(string_id cls) const
+        {
+            // Most of the class selectors don't match, the mask rejects them without the search. The linear search is
+            // faster than the binary one for the usual number of classes.
+            return (m_class_mask & class_bit(cls)) &&
+                   std::find(m_classes.begin(), m_classes.end(), cls) != m_classes.end();
+        }
+        // Class names split from the class attribute, lowercased in quirks mode like the class ids
+        string_vector   str_classes() const;
+        static uint64_t class_bit(string_id cls)
+        {
+            return uint64_t(1) << (static_cast<unsigned>(cls) % 64);
+        }
+        // All attribute values in their original case, in the order they were set
+        const html_attribute::vector& attrs() const
         {
-            return m_str_classes;
+            return m_attrs;
         }
 
         void        set_attr(const char* name, const char* val) override;
         const char* get_attr(const char* name, const char* def = nullptr) const override;
+        const char* get_attr(string_id name, const char* def = nullptr) const override;
         void        apply_stylesheet(const litehtml::css& stylesheet) override;
         void        refresh_styles() override;
+        void        refresh_media_styles(const media_query_list_list::vector& changed) override;
 
         bool is_white_space() const override;
         bool is_body() const override;
@@ -73,6 +116,7 @@ namespace litehtml
         bool set_class(const char* pclass, bool add) override;
         bool is_replaced() const override;
         void compute_styles(bool recursive = true) override;
+        void restore_state() override;
         void draw(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
                   const std::shared_ptr<render_item>& ri) override;
         void draw_background(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
@@ -81,6 +125,15 @@ namespace litehtml
         template <class Type>
         const Type& get_property(string_id name, bool inherited, const Type& default_value,
                                  uint_ptr css_properties_member_offset) const;
+        // The same with the declared value taken from the index of the element style, see compute_styles()
+        template <class Type>
+        const Type& get_property(const style_index& declared, string_id name, bool inherited,
+                                 const Type& default_value, uint_ptr css_properties_member_offset) const;
+        // The same for the properties of the css_properties groups, the offset is the member offset in the group
+        template <class Type, class Group>
+        const Type& get_property(const style_index& declared, string_id name, bool inherited,
+                                 const Type& default_value, std::shared_ptr<const Group> css_properties::* group,
+                                 uint_ptr group_member_offset) const;
         bool        get_custom_property(string_id name, css_token_vector& result) const;
 
         elements_list& children();
@@ -106,6 +159,7 @@ namespace litehtml
                                   bool* is_pseudo = nullptr) override;
         void         get_text(std::string& text) const override;
         void         parse_attributes() override;
+        void         get_memory_usage(memory_usage_info& usage) const override;
 
         void get_content_size(size& sz, pixel_t max_width) override;
         void add_style(const style& style) override;
@@ -133,6 +187,11 @@ namespace litehtml
 
       private:
         void handle_counter_properties();
+        // The background group of get_background()
+        std::shared_ptr<const background> get_background_group();
+        void prepare_background(background_cache_item& item, const std::shared_ptr<const background>& bg,
+                                const position& box, const position& content_box,
+                                const std::shared_ptr<render_item>& ri, const css_border_radius* radius);
     };
 
     /************************************************************************/
@@ -148,15 +207,35 @@ namespace litehtml
     const Type& html_tag::get_property(string_id name, bool inherited, const Type& default_value,
                                        uint_ptr css_properties_member_offset) const
     {
-        const property_value& value = m_style.get_property(name);
+        return computed_property(m_style.get_property(name), inherited, default_value, css_properties_member_offset);
+    }
+
+    template <class Type>
+    const Type& html_tag::get_property(const style_index& declared, string_id name, bool inherited,
+                                       const Type& default_value, uint_ptr css_properties_member_offset) const
+    {
+        return computed_property(declared.get_property(name), inherited, default_value, css_properties_member_offset);
+    }
+
+    template <class Type, class Group>
+    const Type& html_tag::get_property(const style_index& declared, string_id name, bool inherited,
+                                       const Type& default_value, std::shared_ptr<const Group> css_properties::* group,
+                                       uint_ptr group_member_offset) const
+    {
+        return computed_property(declared.get_property(name), inherited, default_value, group, group_member_offset);
+    }
 
+    template <class Type>
+    const Type& html_tag::computed_property(const property_value& value, bool inherited, const Type& default_value,
+                                            uint_ptr css_properties_member_offset) const
+    {
         if(value.is<Type>())
         {
             return value.get<Type>();
         }
         if(inherited || value.is<inherit>())
         {
-            if(auto _parent = parent())
+            if(auto* _parent = parent_ptr())
             {
                 // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
                 return *reinterpret_cast<const Type*>(reinterpret_cast<const byte*>(&_parent->css()) +
@@ -168,6 +247,29 @@ namespace litehtml
         return default_value;
     }
 
+    template <class Type, class Group>
+    const Type& html_tag::computed_property(const property_value& value, bool inherited, const Type& default_value,
+                                            std::shared_ptr<const Group> css_properties::* group,
+                                            uint_ptr group_member_offset) const
+    {
+        if(value.is<Type>())
+        {
+            return value.get<Type>();
+        }
+        if(inherited || value.is<inherit>())
+        {
+            if(auto* _parent = parent_ptr())
+            {
+                // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+                return *reinterpret_cast<const Type*>(reinterpret_cast<const byte*>((_parent->css().*group).get()) +
+                                                      group_member_offset);
+                // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+            }
+            return default_value;
+        }
+        return default_value;
+    }
+
 } // namespace litehtml
 
 #endif // LITEHTML_HTML_TAG_H
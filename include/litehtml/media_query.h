@@ -56,6 +56,7 @@ namespace litehtml
     }
 
     struct media_condition;
+    struct media_breakpoints;
 
     // <media-query> = <media-condition> | [ not | only ]? <media-type> [ and <media-condition-without-or> ]?
     struct media_query
@@ -65,6 +66,7 @@ namespace litehtml
         std::vector<media_condition> m_conditions;
 
         trilean check(const media_features& features) const;
+        void    collect_breakpoints(media_breakpoints& breakpoints) const;
     };
 
     struct media_in_parens;
@@ -77,6 +79,7 @@ namespace litehtml
         std::vector<media_in_parens> m_conditions;
 
         trilean check(const media_features& features) const;
+        void    collect_breakpoints(media_breakpoints& breakpoints) const;
     };
 
     // <media-feature> = ( [ <mf-plain> | <mf-boolean> | <mf-range> ] )
@@ -98,6 +101,7 @@ namespace litehtml
         }
         bool compare(float x) const;
         bool check(const media_features& features) const;
+        void collect_breakpoints(media_breakpoints& breakpoints) const;
     };
 
     // <media-in-parens> = ( <media-condition> ) | <media-feature> | <general-enclosed>
@@ -109,6 +113,7 @@ namespace litehtml
         using base::base; // inherit ctors
 
         trilean check(const media_features& features) const;
+        void    collect_breakpoints(media_breakpoints& breakpoints) const;
     };
 
     struct media_query_list
@@ -120,6 +125,7 @@ namespace litehtml
             return m_queries.empty();
         }
         bool check(const media_features& features) const;
+        void collect_breakpoints(media_breakpoints& breakpoints) const;
     };
     media_query_list parse_media_query_list(const css_token_vector& tokens, const std::shared_ptr<document>& doc);
     media_query_list parse_media_query_list(const std::string& str, const std::shared_ptr<document>& doc);
@@ -139,12 +145,33 @@ namespace litehtml
         {
             m_media_query_lists.push_back(mq_list);
         }
+        void add(const media_query_list_list& list)
+        {
+            m_media_query_lists.insert(m_media_query_lists.end(), list.m_media_query_lists.begin(),
+                                       list.m_media_query_lists.end());
+        }
         bool is_used() const
         {
             return m_is_used;
         }
 
         bool apply_media_features(const media_features& features); // returns true if the m_is_used changed
+        void collect_breakpoints(media_breakpoints& breakpoints) const;
+    };
+
+    // The widths and heights where the media queries can change their results. All the viewport sizes between two
+    // neighbour breakpoints give the same results, so resizing the viewport within them doesn't need to evaluate the
+    // queries again, see document::media_changed.
+    struct media_breakpoints
+    {
+        std::vector<float> width;  // sorted
+        std::vector<float> height; // sorted
+        bool size_ratio = false;   // orientation or aspect-ratio is used, the results can change with any resize
+
+        void clear();
+        void sort();
+        // Returns true if the media queries give the same results for both features
+        bool same_results(const media_features& a, const media_features& b) const;
     };
 
 } // namespace litehtml
@@ -0,0 +1,137 @@
+#ifndef LITEHTML_NODE_ARENA_H
+#define LITEHTML_NODE_ARENA_H
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#ifndef LITEHTML_NO_THREADS
+#include <mutex>
+#endif
+
+namespace litehtml
+{
+    // Memory pool of the document nodes: elements, render items and their shared_ptr control blocks.
+    //
+    // The nodes are allocated from large chunks instead of the separate heap blocks, so the tree is placed densely in
+    // memory and creating or destroying the nodes doesn't go to the system allocator. The released blocks are kept in
+    // the free lists by size and reused by the next nodes, so rebuilding the render tree doesn't grow the pool. The
+    // chunks are released with the pool, which lives while the document or any of its nodes lives.
+    //
+    // The arena is optional: the documents use it if the library is built with LITEHTML_NODE_ARENA (the CMake option of
+    // the same name), otherwise the nodes are allocated with std::make_shared. The arena reduces the number of heap
+    // allocations, but the parsing time measured on big pages is the same.
+    class node_arena
+    {
+      public:
+        // Bigger blocks are allocated with operator new. The biggest node is el_image (864 bytes with the control
+        // block on x86-64), make_node checks that every node fits.
+        static constexpr size_t max_pooled = 1024;
+
+        // The block allocate_shared requests for T holds the object and the shared_ptr control block: a vtable pointer
+        // and two counters, which are not bigger than four pointers with the padding.
+        template <class T> static constexpr bool is_pooled()
+        {
+            return sizeof(T) + 4 * sizeof(void*) <= max_pooled;
+        }
+
+      private:
+        static constexpr size_t granularity  = 16;
+        static constexpr size_t chunk_size   = 64 * 1024;
+        static constexpr size_t size_classes = max_pooled / granularity;
+
+        struct free_block
+        {
+            free_block* next;
+        };
+
+#ifndef LITEHTML_NO_THREADS
+        std::mutex m_mutex;
+#endif
+        std::vector<std::unique_ptr<char[]>>   m_chunks;
+        std::array<free_block*, size_classes> m_free{};
+        char*                                  m_pos        = nullptr; // unused space of the last chunk
+        char*                                  m_end        = nullptr;
+        size_t                                 m_used_bytes = 0;
+
+      public:
+        node_arena() = default;
+
+        node_arena(const node_arena&)            = delete;
+        node_arena& operator=(const node_arena&) = delete;
+
+        void* allocate(size_t size);
+        void  deallocate(void* ptr, size_t size);
+
+        // Memory reserved by the chunks
+        size_t reserved_bytes() const
+        {
+            return m_chunks.size() * chunk_size;
+        }
+        // Memory used by the live nodes, including the big ones
+        size_t used_bytes() const
+        {
+            return m_used_bytes;
+        }
+
+      private:
+        static size_t size_class(size_t size)
+        {
+            return (size + granularity - 1) / granularity - 1;
+        }
+    };
+
+    // Standard allocator over the node_arena. It keeps the arena alive, so the nodes can outlive the document.
+    template <class T> class node_allocator
+    {
+        template <class U> friend class node_allocator;
+
+        std::shared_ptr<node_arena> m_arena;
+
+      public:
+        using value_type = T;
+
+        explicit node_allocator(std::shared_ptr<node_arena> arena) :
+            m_arena(std::move(arena))
+        {
+        }
+        template <class U>
+        node_allocator(const node_allocator<U>& other) :
+            m_arena(other.m_arena)
+        {
+        }
+
+        T* allocate(size_t n)
+        {
+            return static_cast<T*>(m_arena->allocate(n * sizeof(T)));
+        }
+        void deallocate(T* ptr, size_t n)
+        {
+            m_arena->deallocate(ptr, n * sizeof(T));
+        }
+
+        template <class U> bool operator==(const node_allocator<U>& other) const
+        {
+            return m_arena == other.m_arena;
+        }
+        template <class U> bool operator!=(const node_allocator<U>& other) const
+        {
+            return m_arena != other.m_arena;
+        }
+    };
+
+    // Creates the node in the arena, or on the heap if there is no arena
+    template <class T, class... Args>
+    std::shared_ptr<T> make_node(const std::shared_ptr<node_arena>& arena, Args&&... args)
+    {
+        static_assert(node_arena::is_pooled<T>(), "The node doesn't fit node_arena blocks, increase max_pooled");
+        if(arena)
+        {
+            return std::allocate_shared<T>(node_allocator<T>(arena), std::forward<Args>(args)...);
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+} // namespace litehtml
+
+#endif // LITEHTML_NODE_ARENA_H
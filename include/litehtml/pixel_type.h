@@ -1,6 +1,7 @@
 #ifndef LITEHTML_PIXEL_TYPE_H
 #define LITEHTML_PIXEL_TYPE_H
 
+#include <cstdint>
 #include <cstdlib>
 namespace litehtml
 {
@@ -228,51 +229,314 @@ namespace litehtml
         }
     };
 
-    constexpr pixel_float_t operator""_px(long double val)
+    // A class that represents a pixel value as a fixed-point number with 1/64 pixel precision, like LayoutUnit of the
+    // browser engines. The operations give the same results on every platform, the arithmetic saturates at the limits
+    // of the range instead of overflowing. It has the same interface as pixel_float_t.
+    class pixel_fixed_t
+    {
+        constexpr static int     fraction_bits = 6;
+        constexpr static int32_t scale         = 1 << fraction_bits;
+        constexpr static int32_t raw_max       = INT32_MAX;
+        constexpr static int32_t raw_min       = INT32_MIN;
+
+        int32_t m_raw = 0;
+
+        constexpr static int32_t saturate(int64_t raw)
+        {
+            return raw > raw_max ? raw_max : (raw < raw_min ? raw_min : static_cast<int32_t>(raw));
+        }
+        constexpr static int32_t from_float(float value)
+        {
+            float scaled = value * static_cast<float>(scale);
+            if(scaled >= static_cast<float>(raw_max))
+            {
+                return raw_max;
+            }
+            if(scaled <= static_cast<float>(raw_min))
+            {
+                return raw_min;
+            }
+            if(!(scaled > static_cast<float>(raw_min)))
+            {
+                return 0; // NaN
+            }
+            return static_cast<int32_t>(scaled < 0 ? scaled - 0.5f : scaled + 0.5f);
+        }
+        constexpr static int64_t from_int(int value)
+        {
+            return static_cast<int64_t>(value) * scale;
+        }
+        constexpr static pixel_fixed_t from_raw(int64_t raw)
+        {
+            pixel_fixed_t ret;
+            ret.m_raw = saturate(raw);
+            return ret;
+        }
+        constexpr static int64_t divide(int64_t a, int64_t b)
+        {
+            if(b == 0)
+            {
+                return a < 0 ? raw_min : raw_max;
+            }
+            return a / b;
+        }
+
+      public:
+        pixel_fixed_t() = default;
+        constexpr pixel_fixed_t(float value) :
+            m_raw(from_float(value))
+        {
+        }
+        constexpr pixel_fixed_t(int value) :
+            m_raw(saturate(from_int(value)))
+        {
+        }
+        constexpr operator float() const
+        {
+            return value();
+        }
+        constexpr operator int() const
+        {
+            return m_raw / scale;
+        }
+        constexpr float value() const
+        {
+            return static_cast<float>(m_raw) / static_cast<float>(scale);
+        }
+        // The value in 1/64 pixels
+        constexpr int32_t raw() const
+        {
+            return m_raw;
+        }
+
+        // Assignment operators
+        constexpr pixel_fixed_t& operator=(float value)
+        {
+            m_raw = from_float(value);
+            return *this;
+        }
+        constexpr pixel_fixed_t& operator=(int value)
+        {
+            m_raw = saturate(from_int(value));
+            return *this;
+        }
+
+        // += operators
+        constexpr pixel_fixed_t& operator+=(pixel_fixed_t value)
+        {
+            return *this = *this + value;
+        }
+        constexpr pixel_fixed_t& operator+=(float value)
+        {
+            return *this = *this + value;
+        }
+        constexpr pixel_fixed_t& operator+=(int value)
+        {
+            return *this = *this + value;
+        }
+
+        // -= operators
+        constexpr pixel_fixed_t& operator-=(float value)
+        {
+            return *this = *this - value;
+        }
+        constexpr pixel_fixed_t& operator-=(int value)
+        {
+            return *this = *this - value;
+        }
+        constexpr pixel_fixed_t& operator-=(pixel_fixed_t value)
+        {
+            return *this = *this - value;
+        }
+
+        // *= operators
+        constexpr pixel_fixed_t& operator*=(float value)
+        {
+            return *this = *this * value;
+        }
+        constexpr pixel_fixed_t& operator*=(int value)
+        {
+            return *this = *this * value;
+        }
+        constexpr pixel_fixed_t& operator*=(pixel_fixed_t value)
+        {
+            return *this = *this * value;
+        }
+
+        // /= operators
+        constexpr pixel_fixed_t& operator/=(float value)
+        {
+            return *this = *this / value;
+        }
+        constexpr pixel_fixed_t& operator/=(int value)
+        {
+            return *this = *this / value;
+        }
+        constexpr pixel_fixed_t& operator/=(pixel_fixed_t value)
+        {
+            return *this = *this / value;
+        }
+
+        // Comparison operators
+        constexpr bool operator==(pixel_fixed_t other) const
+        {
+            return m_raw == other.m_raw;
+        }
+        constexpr bool operator!=(pixel_fixed_t other) const
+        {
+            return m_raw != other.m_raw;
+        }
+        constexpr bool operator<(pixel_fixed_t other) const
+        {
+            return m_raw < other.m_raw;
+        }
+        constexpr bool operator>(pixel_fixed_t other) const
+        {
+            return m_raw > other.m_raw;
+        }
+        constexpr bool operator<=(pixel_fixed_t other) const
+        {
+            return m_raw <= other.m_raw;
+        }
+        constexpr bool operator>=(pixel_fixed_t other) const
+        {
+            return m_raw >= other.m_raw;
+        }
+
+        // Unary - operator
+        constexpr pixel_fixed_t operator-() const
+        {
+            return from_raw(-static_cast<int64_t>(m_raw));
+        }
+
+        // + operators
+        constexpr pixel_fixed_t operator+(pixel_fixed_t other) const
+        {
+            return from_raw(static_cast<int64_t>(m_raw) + other.m_raw);
+        }
+        constexpr pixel_fixed_t operator+(float other) const
+        {
+            return *this + pixel_fixed_t(other);
+        }
+        constexpr pixel_fixed_t operator+(int other) const
+        {
+            return from_raw(m_raw + from_int(other));
+        }
+
+        // - operators
+        constexpr pixel_fixed_t operator-(float other) const
+        {
+            return *this - pixel_fixed_t(other);
+        }
+        constexpr pixel_fixed_t operator-(int other) const
+        {
+            return from_raw(m_raw - from_int(other));
+        }
+        constexpr pixel_fixed_t operator-(pixel_fixed_t other) const
+        {
+            return from_raw(static_cast<int64_t>(m_raw) - other.m_raw);
+        }
+
+        // * operators
+        constexpr pixel_fixed_t operator*(float other) const
+        {
+            return {value() * other};
+        }
+        constexpr pixel_fixed_t operator*(int other) const
+        {
+            return from_raw(static_cast<int64_t>(m_raw) * other);
+        }
+        constexpr pixel_fixed_t operator*(pixel_fixed_t value) const
+        {
+            return from_raw(static_cast<int64_t>(m_raw) * value.m_raw / scale);
+        }
+
+        // / operators
+        constexpr pixel_fixed_t operator/(float value) const
+        {
+            return {this->value() / value};
+        }
+        constexpr pixel_fixed_t operator/(int value) const
+        {
+            return from_raw(divide(m_raw, value));
+        }
+        constexpr pixel_fixed_t operator/(pixel_fixed_t value) const
+        {
+            return from_raw(divide(static_cast<int64_t>(m_raw) * scale, value.m_raw));
+        }
+
+        // Increment and Decrement operators
+        constexpr pixel_fixed_t operator++()
+        {
+            return *this += 1;
+        }
+        constexpr pixel_fixed_t operator++(int)
+        {
+            pixel_fixed_t temp = *this;
+            ++(*this);
+            return temp;
+        }
+        constexpr pixel_fixed_t operator--()
+        {
+            return *this -= 1;
+        }
+        constexpr pixel_fixed_t operator--(int)
+        {
+            pixel_fixed_t temp = *this;
+            --(*this);
+            return temp;
+        }
+    };
+
+#ifdef LITEHTML_FIXED_PIXEL
+    using pixel_t = pixel_fixed_t;
+#else
+    // Define pixel_t as an alias for pixel_float_t
+    using pixel_t = pixel_float_t;
+#endif
+
+    constexpr pixel_t operator""_px(long double val)
     {
         return {static_cast<float>(val)};
     }
 
-    constexpr pixel_float_t operator""_px(unsigned long long val)
+    constexpr pixel_t operator""_px(unsigned long long val)
     {
         return {static_cast<float>(val)};
     }
 
-    constexpr pixel_float_t operator*(float a, pixel_float_t b)
+    constexpr pixel_t operator*(float a, pixel_t b)
     {
         return {a * b.value()};
     }
-    constexpr pixel_float_t operator*(int a, pixel_float_t b)
+    constexpr pixel_t operator*(int a, pixel_t b)
     {
-        return {static_cast<float>(a) * b.value()};
+        return b * a;
     }
-    constexpr pixel_float_t operator+(float a, pixel_float_t b)
+    constexpr pixel_t operator+(float a, pixel_t b)
     {
         return {a + b.value()};
     }
-    constexpr pixel_float_t operator+(int a, pixel_float_t b)
+    constexpr pixel_t operator+(int a, pixel_t b)
     {
-        return {static_cast<float>(a) + b.value()};
+        return pixel_t(a) + b;
     }
-    constexpr pixel_float_t operator-(float a, pixel_float_t b)
+    constexpr pixel_t operator-(float a, pixel_t b)
     {
         return {a - b.value()};
     }
-    constexpr pixel_float_t operator-(int a, pixel_float_t b)
+    constexpr pixel_t operator-(int a, pixel_t b)
     {
-        return {static_cast<float>(a) - b.value()};
+        return pixel_t(a) - b;
     }
-    constexpr pixel_float_t operator/(float a, pixel_float_t b)
+    constexpr pixel_t operator/(float a, pixel_t b)
     {
         return {a / b.value()};
     }
-    constexpr pixel_float_t operator/(int a, pixel_float_t b)
+    constexpr pixel_t operator/(int a, pixel_t b)
     {
-        return {static_cast<float>(a) / b.value()};
+        return pixel_t(a) / b;
     }
 
-    // Define pixel_t as an alias for pixel_float_t
-    using pixel_t = pixel_float_t;
-
 } // namespace litehtml
 #endif // LITEHTML_PIXEL_TYPE_H
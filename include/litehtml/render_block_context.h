@@ -24,7 +24,7 @@ namespace litehtml
 
         std::shared_ptr<render_item> clone() override
         {
-            return std::make_shared<render_item_block_context>(src_el());
+            return make_node<render_item_block_context>(src_el()->get_arena(), src_el());
         }
         pixel_t get_first_baseline() override;
         pixel_t get_last_baseline() override;
@@ -20,7 +20,7 @@ namespace litehtml
 
         std::shared_ptr<render_item> clone() override
         {
-            return std::make_shared<render_item_image>(src_el());
+            return make_node<render_item_image>(src_el()->get_arena(), src_el());
         }
     };
 } // namespace litehtml
@@ -41,6 +41,7 @@ namespace litehtml
         void clear_inline_boxes() override
         {
             m_boxes.clear();
+            clear_background_cache();
         }
         pixel_t get_first_baseline() override
         {
@@ -53,7 +54,7 @@ namespace litehtml
 
         std::shared_ptr<render_item> clone() override
         {
-            return std::make_shared<render_item_inline>(src_el());
+            return make_node<render_item_inline>(src_el()->get_arena(), src_el());
         }
         void y_shift(pixel_t shift) override
         {
@@ -56,11 +56,12 @@ namespace litehtml
 
         std::shared_ptr<render_item> clone() override
         {
-            return std::make_shared<render_item_inline_context>(src_el());
+            return make_node<render_item_inline_context>(src_el()->get_arena(), src_el());
         }
 
         pixel_t get_first_baseline() override;
         pixel_t get_last_baseline() override;
+        void    get_memory_usage(memory_usage_info& usage) const override;
     };
 } // namespace litehtml
 
@@ -16,19 +16,41 @@ namespace litehtml
 {
     class element;
 
+    // Background layers prepared for one box of the render item. See html_tag::draw_background
+    struct background_cache_item
+    {
+        using vector = std::vector<background_cache_item>;
+
+        std::shared_ptr<const background> bg; // holds the background, so a new one can't get its address
+        position                          box;
+        bool                              valid = false;
+        background_prepared_layer::vector layers;
+
+        bool is_valid(const std::shared_ptr<const background>& _bg, const position& _box) const
+        {
+            return valid && bg == _bg && box == _box;
+        }
+    };
+
     class render_item : public std::enable_shared_from_this<render_item>
     {
       protected:
         std::shared_ptr<element>                  m_element;
         std::weak_ptr<render_item>                m_parent;
-        std::list<std::shared_ptr<render_item>>   m_children;
+        render_item*                              m_parent_ptr = nullptr; // m_parent without reference counting
+        std::vector<std::shared_ptr<render_item>> m_children;
         margins                                   m_margins;
         margins                                   m_padding;
         margins                                   m_borders;
         position                                  m_pos;
-        bool                                      m_skip = false;
+        bool                                      m_skip       = false;
+        int                                       m_list_index = 0; // the list item number, see render_item_block::init
         std::vector<std::shared_ptr<render_item>> m_positioned;
         std::shared_ptr<scroll_view>              m_scroll_view;
+        layer_type                                m_layer = layer_type_none;
+        // true if the children are drawn inside the content box, so the overflow clip can be skipped
+        bool                                      m_content_inside = false;
+        background_cache_item::vector             m_background_cache;
 
         containing_block_context calculate_containing_block_context(const containing_block_context& cb_context);
         void                     calc_cb_length(const css_length& len, pixel_t percent_base,
@@ -43,7 +65,7 @@ namespace litehtml
       public:
         explicit render_item(std::shared_ptr<element> src_el);
 
-        virtual ~render_item() = default;
+        virtual ~render_item();
 
         pixel_t get_scroll_left() const
         {
@@ -84,11 +106,39 @@ namespace litehtml
             return m_scroll_view ? m_scroll_view->is_v_scrollable(dy) : false;
         }
 
-        std::list<std::shared_ptr<render_item>>& children()
+        std::vector<std::shared_ptr<render_item>>& children()
         {
             return m_children;
         }
 
+        // Returns the type of the layer started by this item, layer_type_none if the item belongs to the parent layer
+        layer_type get_layer_type() const
+        {
+            return m_layer;
+        }
+
+        // Background layers prepared by html_tag::draw_background, one item per box.
+        // The cache is cleared on layout and on styles change.
+        background_cache_item::vector& background_cache()
+        {
+            return m_background_cache;
+        }
+
+        int list_index() const
+        {
+            return m_list_index;
+        }
+
+        void list_index(int index)
+        {
+            m_list_index = index;
+        }
+
+        void clear_background_cache()
+        {
+            m_background_cache.clear();
+        }
+
         // Access to the m_pos
         position& pos()
         {
@@ -210,6 +260,13 @@ namespace litehtml
         {
             return m_parent.lock();
         }
+        // The parent without the reference counting, it is valid while the item is in the render tree. The destroyed
+        // item resets the parent of its children.
+        render_item* parent_ptr() const
+        {
+            assert(!m_parent_ptr || !m_parent.expired());
+            return m_parent_ptr;
+        }
 
         margins& get_margins()
         {
@@ -373,7 +430,8 @@ namespace litehtml
 
         void parent(const std::shared_ptr<render_item>& par)
         {
-            m_parent = par;
+            m_parent     = par;
+            m_parent_ptr = par.get();
         }
 
         const std::shared_ptr<element>& src_el() const
@@ -419,7 +477,7 @@ namespace litehtml
 
         bool is_flex_item() const
         {
-            auto par = parent();
+            auto* par = parent_ptr();
             return par && (par->css().get_display() == display_inline_flex || par->css().get_display() == display_flex);
         }
 
@@ -450,7 +508,7 @@ namespace litehtml
 
         virtual std::shared_ptr<render_item> clone()
         {
-            return std::make_shared<render_item>(src_el());
+            return make_node<render_item>(src_el()->get_arena(), src_el());
         }
         std::tuple<std::shared_ptr<litehtml::render_item>, std::shared_ptr<litehtml::render_item>,
                    std::shared_ptr<litehtml::render_item>>
@@ -463,6 +521,10 @@ namespace litehtml
         void add_positioned(const std::shared_ptr<litehtml::render_item>& el);
         void get_redraw_box(litehtml::position& pos, pixel_t x = 0_px, pixel_t y = 0_px);
         void calc_document_size(litehtml::size& sz, pixel_t x = 0_px, pixel_t y = 0_px);
+        // Returns true if the children are drawn inside the box. x and y are the position of the children origin.
+        bool is_content_inside(const position& box, pixel_t x, pixel_t y) const;
+        // Adds the memory used by the render item and its children
+        virtual void get_memory_usage(memory_usage_info& usage) const;
 
         /**
          * @brief Call func for all inline boxes
@@ -480,6 +542,35 @@ namespace litehtml
         virtual void add_inline_box(const position& /*box*/) {};
         virtual void clear_inline_boxes() {};
         void draw_stacking_context(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip, bool with_positioned);
+        /**
+         * Finds the fixed elements and the scroll boxes that can be rasterized separately from the document.
+         * Marks them as layers and adds them into the layers vector.
+         * @param layers found layers
+         * @param parent_layer type of the layer the children belong to
+         */
+        void collect_layers(std::vector<std::shared_ptr<render_item>>& layers,
+                            layer_type                                 parent_layer = layer_type_document);
+        void get_layer_info(layer_info& info);
+        /**
+         * Returns true if a positioned item of the subtree overlaps the box. The layer subtree, the ancestors of the
+         * layer, the fixed layers and the items with negative z-index, which are drawn under the in-flow content,
+         * are skipped.
+         * @param layer the layer item
+         * @param box the layer box
+         * @param layer_found set to true if the layer is in the subtree
+         */
+        bool is_overlapped_by_positioned(const render_item* layer, const position& box, bool& layer_found) const;
+        // Draws the layer content with the parent layer
+        void reset_layer()
+        {
+            m_layer = layer_type_none;
+        }
+        /**
+         * Draws the content of the layer started by this item.
+         * Fixed layers are drawn relative to the viewport, scroll layers are drawn relative to the content box
+         * without the scroll shift.
+         */
+        void            draw_layer(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip);
         virtual void    draw_children(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip, draw_flag flag,
                                       int zindex);
         virtual pixel_t get_draw_vertical_offset()
@@ -21,7 +21,7 @@ namespace litehtml
 
         std::shared_ptr<render_item> clone() override
         {
-            return std::make_shared<render_item_table>(src_el());
+            return make_node<render_item_table>(src_el()->get_arena(), src_el());
         }
         void    draw_children(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip, draw_flag flag,
                               int zindex) override;
@@ -39,7 +39,7 @@ namespace litehtml
 
         std::shared_ptr<render_item> clone() override
         {
-            return std::make_shared<render_item_table_part>(src_el());
+            return make_node<render_item_table_part>(src_el()->get_arena(), src_el());
         }
     };
 
@@ -53,7 +53,7 @@ namespace litehtml
 
         std::shared_ptr<render_item> clone() override
         {
-            return std::make_shared<render_item_table_row>(src_el());
+            return make_node<render_item_table_row>(src_el()->get_arena(), src_el());
         }
         bool for_inline_boxes([[maybe_unused]] const std::function<bool(const position& box, bool first, bool last)>&
                                   process) const override;
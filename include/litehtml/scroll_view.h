@@ -51,6 +51,11 @@ namespace litehtml
             return m_viewport;
         }
 
+        const size& get_scroll_size() const
+        {
+            return m_scroll_size;
+        }
+
         bool is_h_scrollable(const pixel_t dx) const
         {
             if(m_scroll_size.width == 0_px)
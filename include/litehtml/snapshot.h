@@ -0,0 +1,282 @@
+#ifndef LITEHTML_SNAPSHOT_H
+#define LITEHTML_SNAPSHOT_H
+
+#include "css_length.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace litehtml
+{
+    // The fields of a structure stored in the snapshots: the specializations have
+    //     static constexpr auto fields = std::make_tuple(&T::field1, &T::field2, ...);
+    // The structures are written field by field, so the padding bytes are not written. See css_properties.cpp.
+    template <class T> struct snapshot_fields;
+
+    // The valid values of an enum stored in the snapshots: the specializations have
+    //     static bool is_valid(std::underlying_type_t<T> val);
+    // The enums are checked on reading, the switches of the render and layout code expect the values of the enum only.
+    template <class T> struct snapshot_enum;
+
+    // The enums with the values from 0 to count - 1
+    template <class T, size_t count> struct snapshot_enum_count
+    {
+        static bool is_valid(std::underlying_type_t<T> val)
+        {
+            // The negative values become too big
+            return static_cast<std::make_unsigned_t<decltype(val)>>(val) < count;
+        }
+    };
+
+    template <> struct snapshot_enum<css_units> : snapshot_enum_count<css_units, css_units_ch + 1>
+    {
+    };
+
+    // The streams of the binary document snapshots, see document::serialize(). Counts and string lengths are stored as
+    // variable-length integers, the numbers and enums as their bytes. So a snapshot can be read by the same build of the
+    // library only, the snapshot header keeps the size of css_properties to reject the snapshots of other builds.
+    //
+    // The shared property groups (see css_properties) are written once, the next references to the same group are
+    // written as its number. Number 0 is the initial group of the type. The blocks are written once as well, the next
+    // blocks with the same bytes are written as the number of the first one.
+    class snapshot_writer
+    {
+        std::string&                            m_out;
+        std::unordered_map<const void*, size_t> m_groups;
+        std::unordered_map<std::string, size_t> m_blocks;
+
+      public:
+        explicit snapshot_writer(std::string& out) :
+            m_out(out)
+        {
+        }
+
+        void write_byte(uint8_t val)
+        {
+            m_out += static_cast<char>(val);
+        }
+
+        void write_size(size_t val);
+        void write_block(const std::string& bytes);
+
+        void write(const std::string& str);
+        void write(const css_length& len);
+        void write(pixel_t val);
+
+        template <class T> void write(const T& val)
+        {
+            if constexpr(std::is_arithmetic_v<T> || std::is_enum_v<T>)
+            {
+                m_out.append(reinterpret_cast<const char*>(&val), sizeof(T));
+            } else
+            {
+                std::apply([this, &val](auto... field) { (write(val.*field), ...); }, snapshot_fields<T>::fields);
+            }
+        }
+
+        template <class T> void write(const std::vector<T>& vec)
+        {
+            write_size(vec.size());
+            for(const auto& val : vec)
+            {
+                write(val);
+            }
+        }
+
+        template <class T> void write(const std::optional<T>& val)
+        {
+            write(val.has_value());
+            if(val)
+            {
+                write(*val);
+            }
+        }
+
+        // write_fields(const Group&) is called for the groups that were not written yet
+        template <class Group, class Fn>
+        void write_group(const std::shared_ptr<const Group>& group, const std::shared_ptr<const Group>& initial,
+                         Fn&& write_fields)
+        {
+            if(group == initial)
+            {
+                write_size(0);
+                return;
+            }
+            auto ins = m_groups.emplace(group.get(), m_groups.size() + 1);
+            write_size(ins.first->second);
+            if(ins.second)
+            {
+                write_fields(*group);
+            }
+        }
+    };
+
+    // The read functions return false if the data is truncated or invalid: the enums out of their range and the NaN and
+    // infinite floats are rejected as well, so the reader is safe on any data.
+    class snapshot_reader
+    {
+        const char* m_pos;
+        const char* m_end;
+        // The groups are checked for the type, a wrong number in the data must not make a group of another type
+        std::vector<std::pair<std::shared_ptr<const void>, const std::type_info*>> m_groups;
+        std::vector<std::pair<const char*, size_t>>                                m_blocks;
+
+        bool read_bytes(void* dst, size_t size)
+        {
+            if(size > remaining())
+            {
+                return false;
+            }
+            memcpy(dst, m_pos, size);
+            m_pos += size;
+            return true;
+        }
+
+      public:
+        snapshot_reader(const char* data, size_t size) :
+            m_pos(data),
+            m_end(data + size)
+        {
+        }
+
+        size_t remaining() const
+        {
+            return static_cast<size_t>(m_end - m_pos);
+        }
+
+        bool read_byte(uint8_t& val)
+        {
+            if(m_pos == m_end)
+            {
+                return false;
+            }
+            val = static_cast<uint8_t>(*m_pos++);
+            return true;
+        }
+
+        bool read_size(size_t& val);
+        // Returns the reader of the block bytes
+        bool read_block(snapshot_reader& block);
+
+        bool read(std::string& str);
+        bool read(css_length& len);
+        bool read(pixel_t& val);
+
+        template <class T> bool read(T& val)
+        {
+            if constexpr(std::is_same_v<T, bool>)
+            {
+                uint8_t b = 0;
+                if(!read_byte(b) || b > 1)
+                {
+                    return false;
+                }
+                val = b != 0;
+                return true;
+            } else if constexpr(std::is_enum_v<T>)
+            {
+                std::underlying_type_t<T> raw{};
+                if(!read_bytes(&raw, sizeof(raw)) || !snapshot_enum<T>::is_valid(raw))
+                {
+                    return false;
+                }
+                val = static_cast<T>(raw);
+                return true;
+            } else if constexpr(std::is_floating_point_v<T>)
+            {
+                return read_bytes(&val, sizeof(T)) && std::isfinite(val);
+            } else if constexpr(std::is_arithmetic_v<T>)
+            {
+                return read_bytes(&val, sizeof(T));
+            } else
+            {
+                return std::apply([this, &val](auto... field) { return (read(val.*field) && ...); },
+                                  snapshot_fields<T>::fields);
+            }
+        }
+
+        template <class T> bool read(std::vector<T>& vec)
+        {
+            // Every value takes at least one byte, so the count can't be bigger than the rest of the data
+            size_t count = 0;
+            if(!read_size(count) || count > remaining())
+            {
+                return false;
+            }
+            vec.resize(count);
+            for(auto& val : vec)
+            {
+                if(!read(val))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <class T> bool read(std::optional<T>& val)
+        {
+            bool has_value = false;
+            if(!read(has_value))
+            {
+                return false;
+            }
+            if(!has_value)
+            {
+                val.reset();
+                return true;
+            }
+            return read(val.emplace());
+        }
+
+        // read_fields(Group&) reads the groups written by write_fields, the other ones are taken from the read ones
+        template <class Group, class Fn>
+        bool read_group(std::shared_ptr<const Group>& group, const std::shared_ptr<const Group>& initial,
+                        Fn&& read_fields)
+        {
+            size_t idx = 0;
+            if(!read_size(idx))
+            {
+                return false;
+            }
+            if(idx == 0)
+            {
+                group = initial;
+                return true;
+            }
+            if(idx <= m_groups.size())
+            {
+                const auto& item = m_groups[idx - 1];
+                if(*item.second != typeid(Group))
+                {
+                    return false;
+                }
+                group = std::static_pointer_cast<const Group>(item.first);
+                return true;
+            }
+            if(idx != m_groups.size() + 1)
+            {
+                return false;
+            }
+            auto ret = std::make_shared<Group>();
+            if(!read_fields(*ret))
+            {
+                return false;
+            }
+            m_groups.emplace_back(ret, &typeid(Group));
+            group = std::move(ret);
+            return true;
+        }
+    };
+} // namespace litehtml
+
+#endif // LITEHTML_SNAPSHOT_H
@@ -31,6 +31,10 @@ namespace litehtml
         __tag_before_, // note: real tag cannot start with '-'
         __tag_after_,
 
+        // HTML attributes
+        _class_, _id_, _src_, _href_, _rel_, _align_, _valign_, _bgcolor_, _cellspacing_, _colspan_, _rowspan_, _start_,
+        _face_, _size_,
+
         // CSS pseudo-elements
         _before_, _after_,
 
@@ -45,6 +49,7 @@ namespace litehtml
         // Corner properties must go in this order: top-left, top-right, bottom-right, bottom-left (clockwise starting
         // from the top-left). This is used in style::add_four_properties() for margin-*, padding-*,
         // border-*-{width,style,color} and border-*-*-radius{,-x,-y}.
+        // The names from _background_ to _counter_increment_ are indexed by style_index.
         _background_, _background_color_, _background_image_, _background_image_baseurl_, _background_repeat_,
         _background_origin_, _background_clip_, _background_attachment_, _background_size_, _background_position_,
         _background_position_x_, _background_position_y_, _background_gradient_,
@@ -111,6 +116,8 @@ namespace litehtml
 
     string_id          _id(const std::string& str);
     const std::string& _s(string_id id);
+    // Returns the id of str or empty_id if str was never passed to _id(). Unlike _id() it doesn't add str to the table.
+    string_id find_id(const char* str);
 
 } // namespace litehtml
 
@@ -8,6 +8,9 @@
 #include "gradient.h"
 #include "web_color.h"
 
+#include <array>
+#include <initializer_list>
+
 namespace litehtml
 {
     struct invalid
@@ -40,6 +43,8 @@ namespace litehtml
     // represents a style block, eg. "color: black; display: inline"
     class style
     {
+        friend class style_index;
+
       public:
         using ptr    = std::shared_ptr<style>;
         using vector = std::vector<style::ptr>;
@@ -64,6 +69,11 @@ namespace litehtml
         {
             return m_properties.empty();
         }
+        // Approximate memory used by the properties
+        size_t memory_usage() const
+        {
+            return m_properties.size() * sizeof(props_map::value_type);
+        }
 
         void combine(const style& src);
         void clear()
@@ -117,6 +127,47 @@ namespace litehtml
         void                    remove_property(string_id name, bool important);
     };
 
+    // The declared properties of the style by the property name, filled in one pass over the style.
+    // Computing the element style looks up every property, with the index a lookup is an array read instead of the map
+    // search. html_tag::compute_styles() builds it and passes it to css_properties::compute(). Only the CSS property names from _background_ to _counter_increment_ are indexed, the other names are
+    // looked up in the style.
+    class style_index
+    {
+        static constexpr int first_property = _background_;
+        static constexpr int last_property  = _counter_increment_;
+
+        const style&                                                           m_style;
+        std::array<const property_value*, last_property - first_property + 1> m_properties{};
+
+        static const property_value m_not_found;
+
+      public:
+        explicit style_index(const style& st);
+
+        const property_value& get_property(string_id name) const
+        {
+            if(name >= first_property && name <= last_property)
+            {
+                const property_value* value = m_properties[name - first_property];
+                return value ? *value : m_not_found;
+            }
+            return m_style.get_property(name);
+        }
+
+        // Returns true if the style has any of the properties
+        bool has_any_property(std::initializer_list<string_id> names) const
+        {
+            for(string_id name : names)
+            {
+                if(!get_property(name).is<invalid>())
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
     bool parse_url(const css_token& token, std::string& url);
     bool parse_length(const css_token& tok, css_length& length, int options, css_values keywords = {});
     bool parse_angle(const css_token& tok, float& angle, bool percents_allowed = false);
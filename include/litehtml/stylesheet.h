@@ -61,18 +61,35 @@ namespace litehtml
     class css
     {
         css_selector::vector m_selectors;
+        // The stylesheet is parsed to be shared between documents (see stylesheet_cache), its media lists are not
+        // added to the document. The document gets copies of them in add_selectors.
+        bool m_shared      = false;
+        bool m_has_imports = false;
 
       public:
+        css() = default;
+        explicit css(bool shared) :
+            m_shared(shared)
+        {
+        }
+
         const css_selector::vector& selectors() const
         {
             return m_selectors;
         }
+        bool has_imports() const
+        {
+            return m_has_imports;
+        }
 
         template <class Input>
         void parse_css_stylesheet(const Input& input, const std::string& baseurl, const std::shared_ptr<document>& doc,
                                   const media_query_list_list::ptr& media = nullptr, bool top_level = true);
 
         void sort_selectors();
+        // Adds copies of the selectors of the shared stylesheet. The media lists are copied and combined with the
+        // media, the declaration blocks are shared.
+        void add_selectors(const css& sheet, const media_query_list_list::ptr& media, document* doc);
 
       private:
         bool parse_style_rule(const raw_rule::ptr& rule, const std::string& baseurl,
@@ -0,0 +1,86 @@
+#ifndef LITEHTML_STYLESHEET_CACHE_H
+#define LITEHTML_STYLESHEET_CACHE_H
+
+#include "stylesheet.h"
+
+#include <list>
+#include <unordered_map>
+
+#ifndef LITEHTML_NO_THREADS
+#include <mutex>
+#endif
+
+namespace litehtml
+{
+    // Process-wide cache of the parsed stylesheets.
+    //
+    // Documents usually share the master stylesheet and the same few site stylesheets. The cache keeps the parsed
+    // stylesheet by its text, base url and document mode, so the other documents copy the selectors instead of
+    // parsing the text again. The declaration blocks are immutable and shared between documents, the selectors and
+    // media lists are copied, because the document keeps its own order and media state in them.
+    //
+    // The cache is disabled by default, see set_capacity. The parsed stylesheet depends on the document_container
+    // (system colors, default font size in the media queries, @supports), so the cache must be enabled only if all
+    // the containers give the same results. The stylesheets with @import rules are not cached.
+    class stylesheet_cache
+    {
+      public:
+        struct statistics
+        {
+            size_t hits    = 0;
+            size_t misses  = 0;
+            size_t entries = 0;
+        };
+
+      private:
+        struct cache_entry
+        {
+            size_t                     hash = 0;
+            std::string                text;
+            std::string                baseurl;
+            document_mode              mode = no_quirks_mode;
+            std::shared_ptr<const css> sheet;
+        };
+
+        using entries_list = std::list<cache_entry>;
+
+#ifndef LITEHTML_NO_THREADS
+        std::mutex m_mutex;
+#endif
+        entries_list                                            m_entries; // the most recently used first
+        std::unordered_multimap<size_t, entries_list::iterator> m_index;   // by the text hash
+        size_t                                                  m_capacity = 0;
+        statistics                                              m_stats;
+
+        stylesheet_cache() = default;
+
+      public:
+        stylesheet_cache(const stylesheet_cache&)            = delete;
+        stylesheet_cache& operator=(const stylesheet_cache&) = delete;
+
+        static stylesheet_cache& instance();
+
+        // Sets the maximum number of the cached stylesheets, the least recently used ones are released.
+        // 0 disables the cache.
+        void   set_capacity(size_t count);
+        size_t capacity();
+        void   clear();
+
+        statistics get_statistics();
+
+        // Parses the stylesheet into the target like css::parse_css_stylesheet does, the parsed stylesheet is taken
+        // from the cache if possible.
+        void parse_css_stylesheet(css& target, const std::string& text, const std::string& baseurl,
+                                  const std::shared_ptr<document>&  doc,
+                                  const media_query_list_list::ptr& media = nullptr);
+
+      private:
+        std::shared_ptr<const css> find(size_t hash, const std::string& text, const std::string& baseurl,
+                                        document_mode mode);
+        void insert(size_t hash, const std::string& text, const std::string& baseurl, document_mode mode,
+                    const std::shared_ptr<const css>& sheet);
+        void remove(entries_list::iterator iter);
+    };
+} // namespace litehtml
+
+#endif // LITEHTML_STYLESHEET_CACHE_H
@@ -7,6 +7,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_set>
 #include <list>
 #include <variant>
 #include <algorithm>
@@ -21,7 +22,7 @@ namespace litehtml
     class element;
 
     using string_map    = std::map<std::string, std::string>;
-    using elements_list = std::list<std::shared_ptr<element>>;
+    using elements_list = std::vector<std::shared_ptr<element>>;
     using int_vector    = std::vector<int>;
     using string_vector = std::vector<std::string>;
     using pixel_vector  = std::vector<pixel_t>;
@@ -647,6 +648,50 @@ namespace litehtml
         render_fixed_only,
     };
 
+    enum layer_type
+    {
+        layer_type_none,
+        layer_type_document, // The document itself without the content of other layers
+        layer_type_fixed,    // Element with "position: fixed"
+        layer_type_scroll,   // Content of the element with "overflow: scroll" or "overflow: auto"
+    };
+
+    // Description of the layer that can be rasterized separately and composited with the document.
+    // See document::get_layers() and document::draw_layer().
+    struct layer_info
+    {
+        using vector = std::vector<layer_info>;
+
+        uint_ptr   id   = 0; // Layer identifier. The document layer is always 0.
+        layer_type type = layer_type_document;
+        // Placement of the layer. Fixed layers are placed in the viewport coordinates, scroll layers are placed
+        // in the document coordinates and are clipped by this box.
+        position box;
+        // Size of the layer content. For the scroll layers this is the size of the scrolled content.
+        size content_size;
+        // Scroll position of the scroll layer content
+        pixel_t scroll_left;
+        pixel_t scroll_top;
+        int     z_index = 0;
+    };
+
+    // Approximate memory used by the document, in bytes. See document::memory_usage().
+    struct memory_usage_info
+    {
+        size_t dom         = 0; // elements, their attributes and links
+        size_t styles      = 0; // stylesheets, style blocks, used selectors and computed properties
+        size_t render_tree = 0; // render items and line boxes
+        size_t text        = 0; // content of the text nodes, comments and scripts
+
+        // The counted property groups, a group shared by many elements is counted once
+        std::unordered_set<const void*> groups;
+
+        size_t total() const
+        {
+            return dom + styles + render_tree + text;
+        }
+    };
+
     constexpr auto split_delims_spaces = " \t\r\n\f\v";
 
 } // namespace litehtml
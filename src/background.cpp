@@ -759,6 +759,139 @@ namespace litehtml
         }
     }
 
+    bool litehtml::background::prepare_layer(int idx, position pos, const element* el,
+                                             const std::shared_ptr<render_item>& ri,
+                                             background_prepared_layer&          prepared) const
+    {
+        if(!get_layer(idx, pos, el, ri, prepared.layer))
+        {
+            return false;
+        }
+        prepared.idx      = idx;
+        prepared.type     = get_layer_type(idx);
+        prepared.complete = true;
+
+        // Gradients are calculated for the rounded boxes, the same way draw_layer() is called
+        background_layer rounded = prepared.layer;
+        rounded.border_box.round();
+        rounded.clip_box.round();
+        rounded.origin_box.round();
+        prepared.gradient_origin.set(static_cast<float>(rounded.origin_box.x),
+                                     static_cast<float>(rounded.origin_box.y));
+
+        switch(prepared.type)
+        {
+        case background::type_color:
+            prepared.color = get_color_layer(idx);
+            break;
+        case background::type_image:
+            prepared.image = get_image_layer(idx);
+            if(prepared.image)
+            {
+                litehtml::size img_size;
+                el->get_document()->container()->get_image_size(prepared.image->url.c_str(),
+                                                                prepared.image->base_url.c_str(), img_size);
+                prepared.complete = img_size.width != 0_px && img_size.height != 0_px;
+            }
+            break;
+        case background::type_linear_gradient:
+            if(rounded.origin_box.width != 0_px && rounded.origin_box.height != 0_px)
+            {
+                prepared.linear_gradient = get_linear_gradient_layer(idx, rounded);
+            }
+            break;
+        case background::type_radial_gradient:
+            if(rounded.origin_box.width != 0_px && rounded.origin_box.height != 0_px)
+            {
+                prepared.radial_gradient = get_radial_gradient_layer(idx, rounded);
+            }
+            break;
+        case background::type_conic_gradient:
+            if(rounded.origin_box.width != 0_px && rounded.origin_box.height != 0_px)
+            {
+                prepared.conic_gradient = get_conic_gradient_layer(idx, rounded);
+            }
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    litehtml::background_layer litehtml::background_prepared_layer::get_layer(pixel_t x, pixel_t y) const
+    {
+        background_layer ret  = layer;
+        ret.border_box.x     += x;
+        ret.border_box.y     += y;
+        ret.clip_box.x       += x;
+        ret.clip_box.y       += y;
+        // Color layer has no origin box
+        if(type != background::type_color)
+        {
+            ret.origin_box.x += x;
+            ret.origin_box.y += y;
+        }
+        return ret;
+    }
+
+    void litehtml::background_prepared_layer::draw(uint_ptr hdc, const background_layer& draw_layer,
+                                                   document_container* container)
+    {
+        if(type != background::type_color &&
+           (draw_layer.origin_box.width == 0_px || draw_layer.origin_box.height == 0_px))
+        {
+            return;
+        }
+
+        auto dx = static_cast<float>(draw_layer.origin_box.x) - gradient_origin.x;
+        auto dy = static_cast<float>(draw_layer.origin_box.y) - gradient_origin.y;
+        gradient_origin.set(static_cast<float>(draw_layer.origin_box.x), static_cast<float>(draw_layer.origin_box.y));
+
+        switch(type)
+        {
+        case background::type_color:
+            if(color)
+            {
+                container->draw_solid_fill(hdc, draw_layer, color->color);
+            }
+            break;
+        case background::type_image:
+            if(image)
+            {
+                container->draw_image(hdc, draw_layer, image->url, image->base_url);
+            }
+            break;
+        case background::type_linear_gradient:
+            if(linear_gradient)
+            {
+                linear_gradient->start.x += dx;
+                linear_gradient->start.y += dy;
+                linear_gradient->end.x   += dx;
+                linear_gradient->end.y   += dy;
+                container->draw_linear_gradient(hdc, draw_layer, *linear_gradient);
+            }
+            break;
+        case background::type_radial_gradient:
+            if(radial_gradient)
+            {
+                radial_gradient->position.x += dx;
+                radial_gradient->position.y += dy;
+                container->draw_radial_gradient(hdc, draw_layer, *radial_gradient);
+            }
+            break;
+        case background::type_conic_gradient:
+            if(conic_gradient)
+            {
+                conic_gradient->position.x += dx;
+                conic_gradient->position.y += dy;
+                container->draw_conic_gradient(hdc, draw_layer, *conic_gradient);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
     static void repeat_color_points(std::vector<litehtml::background_layer::color_point>& color_points)
     {
         auto old_points = color_points;
@@ -83,7 +83,7 @@ namespace litehtml
         tmp.reserve(keep_idx.size());
         for(auto idx : keep_idx)
         {
-            tmp.push_back(tokens[idx]);
+            tmp.push_back(std::move(tokens[idx]));
         }
         tokens.swap(tmp);
     }
@@ -128,7 +128,7 @@ namespace litehtml
 
     void componentize(css_token_vector& tokens)
     {
-        css_parser       parser(tokens);
+        css_parser       parser(std::move(tokens));
         css_token_vector result;
         while(true)
         {
@@ -137,9 +137,9 @@ namespace litehtml
             {
                 break;
             }
-            result.push_back(tok);
+            result.push_back(std::move(tok));
         }
-        tokens = result;
+        tokens = std::move(result);
     }
 
     // https://www.w3.org/TR/css-syntax-3/#normalize-into-a-token-stream
@@ -159,8 +159,8 @@ namespace litehtml
     template <> css_token_vector normalize(std::string input, int options, const keep_whitespace_fn& keep_whitespace)
     {
         filter_code_points(input);
-        auto tokens = tokenize(input);
-        return normalize(tokens, options, keep_whitespace);
+        auto tokens = tokenize(std::move(input));
+        return normalize(std::move(tokens), options, keep_whitespace);
     }
 
     // https://www.w3.org/TR/css-syntax-3/#parse-stylesheet
@@ -175,32 +175,32 @@ namespace litehtml
         // 2. Normalize input, and set input to the result.
         auto tokens = normalize(str);
 
-        return parse_stylesheet(tokens, top_level);
+        return parse_stylesheet(std::move(tokens), top_level);
     }
-    raw_rule::vector css_parser::parse_stylesheet(const css_token_vector& input, bool top_level)
+    raw_rule::vector css_parser::parse_stylesheet(css_token_vector input, bool top_level)
     {
         // 3. Create a new stylesheet, with its location set to location.
         // 4. Consume a list of rules from input, with the top-level flag set, and set the stylesheet’s value to the
         // result.
         // 5. Return the stylesheet.
-        return css_parser(input).consume_list_of_rules(top_level);
+        return css_parser(std::move(input)).consume_list_of_rules(top_level);
     }
 
     // https://www.w3.org/TR/css-syntax-3/#consume-the-next-input-token
-    css_token css_parser::next_token()
+    css_token& css_parser::next_token()
     {
         if(m_index == static_cast<int>(m_tokens.size()))
         {
-            return css_token_type(EOF);
+            return m_eof;
         }
         return m_tokens[m_index++];
     }
 
-    css_token css_parser::peek_token()
+    const css_token& css_parser::peek_token()
     {
         if(m_index == static_cast<int>(m_tokens.size()))
         {
-            return css_token_type(EOF);
+            return m_eof;
         }
         return m_tokens[m_index];
     }
@@ -214,7 +214,7 @@ namespace litehtml
         while(true)
         {
             // Repeatedly consume the next input token:
-            css_token token = next_token();
+            const css_token& token = next_token();
 
             switch(token.type)
             {
@@ -277,7 +277,7 @@ namespace litehtml
         while(true)
         {
             // Repeatedly consume the next input token:
-            css_token token = next_token();
+            css_token& token = next_token();
 
             switch(token.type)
             {
@@ -291,14 +291,13 @@ namespace litehtml
                 return rule;
             case CURLY_BLOCK:
                 // Assign the block to the qualified rule’s block. Return the qualified rule.
-                rule->block = token;
+                rule->block = std::move(token);
                 return rule;
             default:
                 // Reconsume the current input token. Consume a component value. Append the returned value to the
                 // qualified rule’s prelude.
                 m_index--;
-                css_token value = consume_component_value();
-                rule->prelude.push_back(value);
+                rule->prelude.push_back(consume_component_value());
             }
         }
     }
@@ -308,13 +307,12 @@ namespace litehtml
     {
         // Consume the next input token. Create a new at-rule with its name set to the value of the current input token,
         // its prelude initially set to an empty list, and its value initially set to nothing.
-        css_token     token = next_token();
-        raw_rule::ptr rule  = std::make_shared<raw_rule>(raw_rule::at, token.str());
+        raw_rule::ptr rule = std::make_shared<raw_rule>(raw_rule::at, next_token().str());
 
         while(true)
         {
             // Repeatedly consume the next input token:
-            token = next_token();
+            css_token& token = next_token();
 
             switch(token.type)
             {
@@ -330,14 +328,13 @@ namespace litehtml
                 return rule;
             case CURLY_BLOCK:
                 // Assign the block to the at-rule’s block. Return the at-rule.
-                rule->block = token;
+                rule->block = std::move(token);
                 return rule;
             default:
                 // Reconsume the current input token. Consume a component value. Append the returned value to the
                 // at-rule’s prelude.
                 m_index--;
-                css_token value = consume_component_value();
-                rule->prelude.push_back(value);
+                rule->prelude.push_back(consume_component_value());
             }
         }
     }
@@ -357,7 +354,7 @@ namespace litehtml
         while(true)
         {
             // Repeatedly consume the next input token and process it as follows:
-            css_token token = next_token();
+            const css_token& token = next_token();
 
             if(token.type == closing_bracket)
             {
@@ -370,8 +367,7 @@ namespace litehtml
             }
             // Reconsume the current input token. Consume a component value and append it to the value of the block.
             m_index--;
-            css_token val = consume_component_value();
-            block.value.push_back(val);
+            block.value.push_back(consume_component_value());
         }
     }
 
@@ -379,7 +375,7 @@ namespace litehtml
     css_token css_parser::consume_component_value()
     {
         // Consume the next input token.
-        css_token token = next_token();
+        css_token& token = next_token();
 
         switch(token.type)
         {
@@ -395,7 +391,7 @@ namespace litehtml
 
             // Otherwise, return the current input token.
         default:
-            return token;
+            return std::move(token);
         }
     }
 
@@ -409,7 +405,7 @@ namespace litehtml
         while(true)
         {
             // Repeatedly consume the next input token and process it as follows:
-            css_token token = next_token();
+            const css_token& token = next_token();
 
             switch(token.type)
             {
@@ -424,8 +420,7 @@ namespace litehtml
                 // Reconsume the current input token. Consume a component value and append the returned value to the
                 // function’s value.
                 m_index--;
-                css_token val = consume_component_value();
-                function.value.push_back(val);
+                function.value.push_back(consume_component_value());
             }
         }
     }
@@ -450,8 +445,7 @@ namespace litehtml
     {
         // Consume the next input token. Create a new declaration with its name set to the value of
         // the current input token and its value initially set to an empty list.
-        css_token       token = next_token();
-        raw_declaration decl  = {token.name(), {}};
+        raw_declaration decl  = {next_token().name(), {}};
         auto&           value = decl.value;
 
         // 1. While the next input token is a <whitespace-token>, consume the next input token.
@@ -508,7 +502,7 @@ namespace litehtml
         while(true)
         {
             // Repeatedly consume the next input token:
-            css_token token = next_token();
+            css_token& token = next_token();
 
             switch(token.type)
             {
@@ -535,7 +529,8 @@ namespace litehtml
             case IDENT:
                 {
                     // Initialize a temporary list initially filled with the current input token.
-                    css_token_vector temp = {token};
+                    css_token_vector temp;
+                    temp.push_back(std::move(token));
                     // As long as the next input token is anything other than a <semicolon-token> or <EOF-token>,
                     // consume a component value and append it to the temporary list.
                     while(!is_one_of(peek_token().type, ';', EOF))
@@ -543,13 +538,13 @@ namespace litehtml
                         temp.push_back(consume_component_value());
                     }
 
-                    css_parser parser(temp);
+                    css_parser parser(std::move(temp));
                     // Consume a declaration from the temporary list.
                     auto decl = parser.consume_declaration();
                     // If anything was returned, append it to decls.
                     if(decl)
                     {
-                        decls.push_back(decl);
+                        decls.push_back(std::move(decl));
                     }
                     break;
                 }
@@ -4,38 +4,40 @@
 #include "document.h"
 #include "html_tag.h"
 #include "document_container.h"
+#include "snapshot.h"
 #include "types.h"
 #include <cstddef>
 
 #define offset(member) offsetof(litehtml::css_properties, member)
+#define group_offset(group, type, member) &litehtml::css_properties::group, offsetof(litehtml::type, member)
 // #define offset(func)	[](const css_properties& css) { return css.func; }
 
-void litehtml::css_properties::compute(const html_tag* el, const document::ptr& doc)
+void litehtml::css_properties::compute(const html_tag* el, const style_index& declared, const document::ptr& doc)
 {
-    m_color = el->get_property<web_color>(_color_, true, web_color::black, offset(m_color));
+    m_color = el->get_property<web_color>(declared, _color_, true, web_color::black, offset(m_color));
 
     m_el_position = static_cast<element_position>(
-        el->get_property<int>(_position_, false, element_position_static, offset(m_el_position)));
-    m_display = static_cast<style_display>(el->get_property<int>(_display_, false, display_inline, offset(m_display)));
+        el->get_property<int>(declared, _position_, false, element_position_static, offset(m_el_position)));
+    m_display = static_cast<style_display>(el->get_property<int>(declared, _display_, false, display_inline, offset(m_display)));
     m_visibility =
-        static_cast<visibility>(el->get_property<int>(_visibility_, true, visibility_visible, offset(m_visibility)));
-    m_float = static_cast<element_float>(el->get_property<int>(_float_, false, float_none, offset(m_float)));
-    m_clear = static_cast<element_clear>(el->get_property<int>(_clear_, false, clear_none, offset(m_clear)));
+        static_cast<visibility>(el->get_property<int>(declared, _visibility_, true, visibility_visible, offset(m_visibility)));
+    m_float = static_cast<element_float>(el->get_property<int>(declared, _float_, false, float_none, offset(m_float)));
+    m_clear = static_cast<element_clear>(el->get_property<int>(declared, _clear_, false, clear_none, offset(m_clear)));
     m_appearance =
-        static_cast<appearance>(el->get_property<int>(_appearance_, false, appearance_none, offset(m_appearance)));
+        static_cast<appearance>(el->get_property<int>(declared, _appearance_, false, appearance_none, offset(m_appearance)));
     m_box_sizing = static_cast<box_sizing>(
-        el->get_property<int>(_box_sizing_, false, box_sizing_content_box, offset(m_box_sizing)));
-    m_overflow = static_cast<overflow>(el->get_property<int>(_overflow_, false, overflow_visible, offset(m_overflow)));
+        el->get_property<int>(declared, _box_sizing_, false, box_sizing_content_box, offset(m_box_sizing)));
+    m_overflow = static_cast<overflow>(el->get_property<int>(declared, _overflow_, false, overflow_visible, offset(m_overflow)));
     m_text_align =
-        static_cast<text_align>(el->get_property<int>(_text_align_, true, text_align_left, offset(m_text_align)));
+        static_cast<text_align>(el->get_property<int>(declared, _text_align_, true, text_align_left, offset(m_text_align)));
     m_vertical_align = static_cast<vertical_align>(
-        el->get_property<int>(_vertical_align_, false, va_baseline, offset(m_vertical_align)));
+        el->get_property<int>(declared, _vertical_align_, false, va_baseline, offset(m_vertical_align)));
     m_text_transform = static_cast<text_transform>(
-        el->get_property<int>(_text_transform_, true, text_transform_none, offset(m_text_transform)));
+        el->get_property<int>(declared, _text_transform_, true, text_transform_none, offset(m_text_transform)));
     m_white_space =
-        static_cast<white_space>(el->get_property<int>(_white_space_, true, white_space_normal, offset(m_white_space)));
+        static_cast<white_space>(el->get_property<int>(declared, _white_space_, true, white_space_normal, offset(m_white_space)));
     m_caption_side = static_cast<caption_side>(
-        el->get_property<int>(_caption_side_, true, caption_side_top, offset(m_caption_side)));
+        el->get_property<int>(declared, _caption_side_, true, caption_side_top, offset(m_caption_side)));
 
     // https://www.w3.org/TR/CSS22/visuren.html#dis-pos-flo
     if(m_display == display_none)
@@ -103,75 +105,74 @@ void litehtml::css_properties::compute(const html_tag* el, const document::ptr&
     }
     // 5. Otherwise, the remaining 'display' property values apply as specified.
 
-    compute_font(el, doc);
-    pixel_t font_size = get_font_size();
+    compute_font(el, declared, doc);
 
     const css_length _auto = css_length::predef_value(0);
-    const css_length none = _auto, normal = _auto;
+    const css_length none  = _auto;
 
-    m_css_width  = el->get_property<css_length>(_width_, false, _auto, offset(m_css_width));
-    m_css_height = el->get_property<css_length>(_height_, false, _auto, offset(m_css_height));
+    m_css_width  = el->get_property<css_length>(declared, _width_, false, _auto, offset(m_css_width));
+    m_css_height = el->get_property<css_length>(declared, _height_, false, _auto, offset(m_css_height));
 
-    m_css_min_width  = el->get_property<css_length>(_min_width_, false, _auto, offset(m_css_min_width));
-    m_css_min_height = el->get_property<css_length>(_min_height_, false, _auto, offset(m_css_min_height));
+    m_css_min_width  = el->get_property<css_length>(declared, _min_width_, false, _auto, offset(m_css_min_width));
+    m_css_min_height = el->get_property<css_length>(declared, _min_height_, false, _auto, offset(m_css_min_height));
 
-    m_css_max_width  = el->get_property<css_length>(_max_width_, false, none, offset(m_css_max_width));
-    m_css_max_height = el->get_property<css_length>(_max_height_, false, none, offset(m_css_max_height));
+    m_css_max_width  = el->get_property<css_length>(declared, _max_width_, false, none, offset(m_css_max_width));
+    m_css_max_height = el->get_property<css_length>(declared, _max_height_, false, none, offset(m_css_max_height));
 
-    doc->cvt_units(m_css_width, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_height, m_font_metrics, 0_px);
+    doc->cvt_units(m_css_width, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_height, m_font->metrics, 0_px);
 
-    doc->cvt_units(m_css_min_width, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_min_height, m_font_metrics, 0_px);
+    doc->cvt_units(m_css_min_width, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_min_height, m_font->metrics, 0_px);
 
-    doc->cvt_units(m_css_max_width, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_max_height, m_font_metrics, 0_px);
+    doc->cvt_units(m_css_max_width, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_max_height, m_font->metrics, 0_px);
 
-    m_css_margins.left   = el->get_property<css_length>(_margin_left_, false, 0.0, offset(m_css_margins.left));
-    m_css_margins.right  = el->get_property<css_length>(_margin_right_, false, 0.0, offset(m_css_margins.right));
-    m_css_margins.top    = el->get_property<css_length>(_margin_top_, false, 0.0, offset(m_css_margins.top));
-    m_css_margins.bottom = el->get_property<css_length>(_margin_bottom_, false, 0.0, offset(m_css_margins.bottom));
+    m_css_margins.left   = el->get_property<css_length>(declared, _margin_left_, false, 0.0, offset(m_css_margins.left));
+    m_css_margins.right  = el->get_property<css_length>(declared, _margin_right_, false, 0.0, offset(m_css_margins.right));
+    m_css_margins.top    = el->get_property<css_length>(declared, _margin_top_, false, 0.0, offset(m_css_margins.top));
+    m_css_margins.bottom = el->get_property<css_length>(declared, _margin_bottom_, false, 0.0, offset(m_css_margins.bottom));
 
-    doc->cvt_units(m_css_margins.left, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_margins.right, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_margins.top, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_margins.bottom, m_font_metrics, 0_px);
+    doc->cvt_units(m_css_margins.left, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_margins.right, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_margins.top, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_margins.bottom, m_font->metrics, 0_px);
 
-    m_css_padding.left   = el->get_property<css_length>(_padding_left_, false, 0.0, offset(m_css_padding.left));
-    m_css_padding.right  = el->get_property<css_length>(_padding_right_, false, 0.0, offset(m_css_padding.right));
-    m_css_padding.top    = el->get_property<css_length>(_padding_top_, false, 0.0, offset(m_css_padding.top));
-    m_css_padding.bottom = el->get_property<css_length>(_padding_bottom_, false, 0.0, offset(m_css_padding.bottom));
+    m_css_padding.left   = el->get_property<css_length>(declared, _padding_left_, false, 0.0, offset(m_css_padding.left));
+    m_css_padding.right  = el->get_property<css_length>(declared, _padding_right_, false, 0.0, offset(m_css_padding.right));
+    m_css_padding.top    = el->get_property<css_length>(declared, _padding_top_, false, 0.0, offset(m_css_padding.top));
+    m_css_padding.bottom = el->get_property<css_length>(declared, _padding_bottom_, false, 0.0, offset(m_css_padding.bottom));
 
-    doc->cvt_units(m_css_padding.left, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_padding.right, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_padding.top, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_padding.bottom, m_font_metrics, 0_px);
+    doc->cvt_units(m_css_padding.left, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_padding.right, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_padding.top, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_padding.bottom, m_font->metrics, 0_px);
 
     m_css_borders.left.color =
-        get_color_property(el, _border_left_color_, false, m_color, offset(m_css_borders.left.color));
+        get_color_property(el, declared, _border_left_color_, false, m_color, offset(m_css_borders.left.color));
     m_css_borders.right.color =
-        get_color_property(el, _border_right_color_, false, m_color, offset(m_css_borders.right.color));
+        get_color_property(el, declared, _border_right_color_, false, m_color, offset(m_css_borders.right.color));
     m_css_borders.top.color =
-        get_color_property(el, _border_top_color_, false, m_color, offset(m_css_borders.top.color));
+        get_color_property(el, declared, _border_top_color_, false, m_color, offset(m_css_borders.top.color));
     m_css_borders.bottom.color =
-        get_color_property(el, _border_bottom_color_, false, m_color, offset(m_css_borders.bottom.color));
+        get_color_property(el, declared, _border_bottom_color_, false, m_color, offset(m_css_borders.bottom.color));
 
     m_css_borders.left.style = static_cast<border_style>(
-        el->get_property<int>(_border_left_style_, false, border_style_none, offset(m_css_borders.left.style)));
+        el->get_property<int>(declared, _border_left_style_, false, border_style_none, offset(m_css_borders.left.style)));
     m_css_borders.right.style = static_cast<border_style>(
-        el->get_property<int>(_border_right_style_, false, border_style_none, offset(m_css_borders.right.style)));
+        el->get_property<int>(declared, _border_right_style_, false, border_style_none, offset(m_css_borders.right.style)));
     m_css_borders.top.style = static_cast<border_style>(
-        el->get_property<int>(_border_top_style_, false, border_style_none, offset(m_css_borders.top.style)));
+        el->get_property<int>(declared, _border_top_style_, false, border_style_none, offset(m_css_borders.top.style)));
     m_css_borders.bottom.style = static_cast<border_style>(
-        el->get_property<int>(_border_bottom_style_, false, border_style_none, offset(m_css_borders.bottom.style)));
+        el->get_property<int>(declared, _border_bottom_style_, false, border_style_none, offset(m_css_borders.bottom.style)));
 
-    m_css_borders.left.width   = el->get_property<css_length>(_border_left_width_, false, border_width_medium_value,
+    m_css_borders.left.width   = el->get_property<css_length>(declared, _border_left_width_, false, border_width_medium_value,
                                                               offset(m_css_borders.left.width));
-    m_css_borders.right.width  = el->get_property<css_length>(_border_right_width_, false, border_width_medium_value,
+    m_css_borders.right.width  = el->get_property<css_length>(declared, _border_right_width_, false, border_width_medium_value,
                                                               offset(m_css_borders.right.width));
-    m_css_borders.top.width    = el->get_property<css_length>(_border_top_width_, false, border_width_medium_value,
+    m_css_borders.top.width    = el->get_property<css_length>(declared, _border_top_width_, false, border_width_medium_value,
                                                               offset(m_css_borders.top.width));
-    m_css_borders.bottom.width = el->get_property<css_length>(_border_bottom_width_, false, border_width_medium_value,
+    m_css_borders.bottom.width = el->get_property<css_length>(declared, _border_bottom_width_, false, border_width_medium_value,
                                                               offset(m_css_borders.bottom.width));
 
     if(m_css_borders.left.style == border_style_none || m_css_borders.left.style == border_style_hidden)
@@ -197,101 +198,105 @@ void litehtml::css_properties::compute(const html_tag* el, const document::ptr&
     snap_border_width(m_css_borders.bottom.width, doc);
 
     m_css_borders.radius.top_left_x =
-        el->get_property<css_length>(_border_top_left_radius_x_, false, 0.0, offset(m_css_borders.radius.top_left_x));
+        el->get_property<css_length>(declared, _border_top_left_radius_x_, false, 0.0, offset(m_css_borders.radius.top_left_x));
     m_css_borders.radius.top_left_y =
-        el->get_property<css_length>(_border_top_left_radius_y_, false, 0.0, offset(m_css_borders.radius.top_left_y));
+        el->get_property<css_length>(declared, _border_top_left_radius_y_, false, 0.0, offset(m_css_borders.radius.top_left_y));
 
     m_css_borders.radius.top_right_x =
-        el->get_property<css_length>(_border_top_right_radius_x_, false, 0.0, offset(m_css_borders.radius.top_right_x));
+        el->get_property<css_length>(declared, _border_top_right_radius_x_, false, 0.0, offset(m_css_borders.radius.top_right_x));
     m_css_borders.radius.top_right_y =
-        el->get_property<css_length>(_border_top_right_radius_y_, false, 0.0, offset(m_css_borders.radius.top_right_y));
+        el->get_property<css_length>(declared, _border_top_right_radius_y_, false, 0.0, offset(m_css_borders.radius.top_right_y));
 
-    m_css_borders.radius.bottom_left_x = el->get_property<css_length>(_border_bottom_left_radius_x_, false, 0.0,
+    m_css_borders.radius.bottom_left_x = el->get_property<css_length>(declared, _border_bottom_left_radius_x_, false, 0.0,
                                                                       offset(m_css_borders.radius.bottom_left_x));
-    m_css_borders.radius.bottom_left_y = el->get_property<css_length>(_border_bottom_left_radius_y_, false, 0.0,
+    m_css_borders.radius.bottom_left_y = el->get_property<css_length>(declared, _border_bottom_left_radius_y_, false, 0.0,
                                                                       offset(m_css_borders.radius.bottom_left_y));
 
-    m_css_borders.radius.bottom_right_x = el->get_property<css_length>(_border_bottom_right_radius_x_, false, 0.0,
+    m_css_borders.radius.bottom_right_x = el->get_property<css_length>(declared, _border_bottom_right_radius_x_, false, 0.0,
                                                                        offset(m_css_borders.radius.bottom_right_x));
-    m_css_borders.radius.bottom_right_y = el->get_property<css_length>(_border_bottom_right_radius_y_, false, 0.0,
+    m_css_borders.radius.bottom_right_y = el->get_property<css_length>(declared, _border_bottom_right_radius_y_, false, 0.0,
                                                                        offset(m_css_borders.radius.bottom_right_y));
 
-    doc->cvt_units(m_css_borders.radius.top_left_x, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_borders.radius.top_left_y, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_borders.radius.top_right_x, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_borders.radius.top_right_y, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_borders.radius.bottom_left_x, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_borders.radius.bottom_left_y, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_borders.radius.bottom_right_x, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_borders.radius.bottom_right_y, m_font_metrics, 0_px);
+    doc->cvt_units(m_css_borders.radius.top_left_x, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_borders.radius.top_left_y, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_borders.radius.top_right_x, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_borders.radius.top_right_y, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_borders.radius.bottom_left_x, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_borders.radius.bottom_left_y, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_borders.radius.bottom_right_x, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_borders.radius.bottom_right_y, m_font->metrics, 0_px);
 
     m_border_collapse = static_cast<border_collapse>(
-        el->get_property<int>(_border_collapse_, true, border_collapse_separate, offset(m_border_collapse)));
+        el->get_property<int>(declared, _border_collapse_, true, border_collapse_separate, offset(m_border_collapse)));
 
     m_css_border_spacing_x =
-        el->get_property<css_length>(__litehtml_border_spacing_x_, true, 0, offset(m_css_border_spacing_x));
+        el->get_property<css_length>(declared, __litehtml_border_spacing_x_, true, 0, offset(m_css_border_spacing_x));
     m_css_border_spacing_y =
-        el->get_property<css_length>(__litehtml_border_spacing_y_, true, 0, offset(m_css_border_spacing_y));
+        el->get_property<css_length>(declared, __litehtml_border_spacing_y_, true, 0, offset(m_css_border_spacing_y));
 
-    doc->cvt_units(m_css_border_spacing_x, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_border_spacing_y, m_font_metrics, 0_px);
+    doc->cvt_units(m_css_border_spacing_x, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_border_spacing_y, m_font->metrics, 0_px);
 
-    m_css_offsets.left   = el->get_property<css_length>(_left_, false, _auto, offset(m_css_offsets.left));
-    m_css_offsets.right  = el->get_property<css_length>(_right_, false, _auto, offset(m_css_offsets.right));
-    m_css_offsets.top    = el->get_property<css_length>(_top_, false, _auto, offset(m_css_offsets.top));
-    m_css_offsets.bottom = el->get_property<css_length>(_bottom_, false, _auto, offset(m_css_offsets.bottom));
+    m_css_offsets.left   = el->get_property<css_length>(declared, _left_, false, _auto, offset(m_css_offsets.left));
+    m_css_offsets.right  = el->get_property<css_length>(declared, _right_, false, _auto, offset(m_css_offsets.right));
+    m_css_offsets.top    = el->get_property<css_length>(declared, _top_, false, _auto, offset(m_css_offsets.top));
+    m_css_offsets.bottom = el->get_property<css_length>(declared, _bottom_, false, _auto, offset(m_css_offsets.bottom));
 
-    doc->cvt_units(m_css_offsets.left, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_offsets.right, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_offsets.top, m_font_metrics, 0_px);
-    doc->cvt_units(m_css_offsets.bottom, m_font_metrics, 0_px);
+    doc->cvt_units(m_css_offsets.left, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_offsets.right, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_offsets.top, m_font->metrics, 0_px);
+    doc->cvt_units(m_css_offsets.bottom, m_font->metrics, 0_px);
 
-    m_z_index = el->get_property<css_length>(_z_index_, false, _auto, offset(m_z_index));
-    m_content = el->get_property<std::string>(_content_, false, "", offset(m_content));
-    m_cursor  = el->get_property<std::string>(_cursor_, true, "auto", offset(m_cursor));
+    m_z_index = el->get_property<css_length>(declared, _z_index_, false, _auto, offset(m_z_index));
 
-    m_css_text_indent = el->get_property<css_length>(_text_indent_, true, 0, offset(m_css_text_indent));
-    doc->cvt_units(m_css_text_indent, m_font_metrics, 0_px);
+    m_css_text_indent = el->get_property<css_length>(declared, _text_indent_, true, 0, offset(m_css_text_indent));
+    doc->cvt_units(m_css_text_indent, m_font->metrics, 0_px);
 
-    m_line_height.css_value =
-        el->get_property<css_length>(_line_height_, true, normal, offset(m_line_height.css_value));
-    if(m_line_height.css_value.is_predefined())
-    {
-        m_line_height.computed_value = m_font_metrics.height;
-    } else if(m_line_height.css_value.units() == css_units_none)
+    compute_list_style(el, declared, doc);
+    compute_background(el, declared, doc);
+    compute_flex(el, declared, doc);
+}
+
+void litehtml::css_properties::compute_list_style(const html_tag* el, const style_index& declared,
+                                                  const document::ptr& doc)
+{
+    // All list-style properties are inherited
+    auto* el_parent = el->parent_ptr();
+    if(el_parent &&
+       !declared.has_any_property({_list_style_type_, _list_style_position_, _list_style_image_, _list_style_image_baseurl_}))
     {
-        m_line_height.computed_value = pixel_t(m_line_height.css_value.val() * font_size.value());
+        m_list_style = el_parent->css().m_list_style;
     } else
     {
-        m_line_height.computed_value =
-            doc->to_pixels(m_line_height.css_value, m_font_metrics, m_font_metrics.font_size);
-        m_line_height.css_value = static_cast<float>(m_line_height.computed_value);
+        auto list_style  = std::make_shared<css_list_style>();
+        list_style->type = static_cast<list_style_type>(el->get_property<int>(declared, 
+            _list_style_type_, true, list_style_type_disc, group_offset(m_list_style, css_list_style, type)));
+        list_style->position = static_cast<list_style_position>(
+            el->get_property<int>(declared, _list_style_position_, true, list_style_position_outside,
+                                  group_offset(m_list_style, css_list_style, position)));
+        list_style->image = el->get_property<std::string>(declared, _list_style_image_, true, "",
+                                                          group_offset(m_list_style, css_list_style, image));
+        if(!list_style->image.empty())
+        {
+            list_style->image_baseurl = el->get_property<std::string>(declared, 
+                _list_style_image_baseurl_, true, "", group_offset(m_list_style, css_list_style, image_baseurl));
+        }
+        m_list_style = std::move(list_style);
     }
 
-    m_list_style_type = static_cast<list_style_type>(
-        el->get_property<int>(_list_style_type_, true, list_style_type_disc, offset(m_list_style_type)));
-    m_list_style_position = static_cast<list_style_position>(
-        el->get_property<int>(_list_style_position_, true, list_style_position_outside, offset(m_list_style_position)));
-
-    m_list_style_image = el->get_property<std::string>(_list_style_image_, true, "", offset(m_list_style_image));
-    if(!m_list_style_image.empty())
+    if(!m_list_style->image.empty())
     {
-        m_list_style_image_baseurl =
-            el->get_property<std::string>(_list_style_image_baseurl_, true, "", offset(m_list_style_image_baseurl));
-        doc->container()->load_image(m_list_style_image.c_str(), m_list_style_image_baseurl.c_str(), true);
+        doc->container()->load_image(m_list_style->image.c_str(), m_list_style->image_baseurl.c_str(), true);
     }
-
-    m_order = el->get_property<int>(_order_, false, 0, offset(m_order));
-
-    compute_background(el, doc);
-    compute_flex(el, doc);
 }
 
 // used for all color properties except `color` (color:currentcolor is converted to color:inherit during parsing)
-litehtml::web_color litehtml::css_properties::get_color_property(const html_tag* el, string_id name, bool inherited,
-                                                                 web_color default_value, uint_ptr member_offset) const
+template <class... Member>
+litehtml::web_color litehtml::css_properties::get_color_property(const html_tag* el, const style_index& declared,
+                                                                 string_id name, bool inherited,
+                                                                 web_color default_value, Member... member) const
 {
-    web_color color = el->get_property<web_color>(name, inherited, default_value, member_offset);
+    web_color color = el->get_property<web_color>(declared, name, inherited, default_value, member...);
     if(color.is_current_color)
     {
         color = m_color;
@@ -313,15 +318,29 @@ namespace litehtml
     };
 } // namespace litehtml
 
-void litehtml::css_properties::compute_font(const html_tag* el, const document::ptr& doc)
+void litehtml::css_properties::compute_font(const html_tag* el, const style_index& declared, const document::ptr& doc)
 {
+    // font-family and the text decoration are a part of the font description
+    compute_misc(el, declared, doc);
+    compute_text_decoration(el, declared);
+
+    // The font is the same as the parent one, if the element doesn't set its own
+    element* el_parent = el->parent_ptr();
+    if(el_parent && el_parent->css().m_misc == m_misc && el_parent->css().m_text_decoration == m_text_decoration &&
+       !declared.has_any_property({_font_size_, _font_weight_, _font_style_, _line_height_}))
+    {
+        m_font = el_parent->css().m_font;
+        return;
+    }
+
+    auto font = std::make_shared<css_font>();
+
     // initialize font size
-    css_length sz = el->get_property<css_length>(_font_size_, true, css_length::predef_value(font_size_medium),
-                                                 offset(m_font_size));
+    css_length sz = el->get_property<css_length>(declared, _font_size_, true, css_length::predef_value(font_size_medium),
+                                                 group_offset(m_font, css_font, size));
 
-    pixel_t      parent_sz     = 0_px;
-    pixel_t      doc_font_size = doc->container()->get_default_font_size();
-    element::ptr el_parent     = el->parent();
+    pixel_t parent_sz     = 0_px;
+    pixel_t doc_font_size = doc->container()->get_default_font_size();
     if(el_parent)
     {
         parent_sz = el_parent->css().get_font_size();
@@ -396,162 +415,259 @@ void litehtml::css_properties::compute_font(const html_tag* el, const document::
         }
     }
 
-    m_font_size = static_cast<float>(font_size);
+    font->size = static_cast<float>(font_size);
 
     // initialize font
-    m_font_family = el->get_property<std::string>(_font_family_, true, doc->container()->get_default_font_name(),
-                                                  offset(m_font_family));
-    m_font_weight = el->get_property<css_length>(_font_weight_, true, css_length::predef_value(font_weight_normal),
-                                                 offset(m_font_weight));
-    m_font_style =
-        static_cast<font_style>(el->get_property<int>(_font_style_, true, font_style_normal, offset(m_font_style)));
-    bool propagate_decoration =
-        !is_one_of(m_display, display_inline_block, display_inline_table, display_inline_flex) &&
-        m_float == float_none && !is_one_of(m_el_position, element_position_absolute, element_position_fixed);
-
-    m_text_decoration_line = el->get_property<int>(_text_decoration_line_, propagate_decoration,
-                                                   text_decoration_line_none, offset(m_text_decoration_line));
-
-    // Merge parent text decoration with child text decoration
-    if(propagate_decoration && el->parent())
-    {
-        m_text_decoration_line |= el->parent()->css().get_text_decoration_line();
-    }
-
-    if(m_text_decoration_line)
-    {
-        m_text_decoration_thickness = el->get_property<css_length>(
-            _text_decoration_thickness_, propagate_decoration, css_length::predef_value(text_decoration_thickness_auto),
-            offset(m_text_decoration_thickness));
-        m_text_decoration_style = static_cast<text_decoration_style>(
-            el->get_property<int>(_text_decoration_style_, propagate_decoration, text_decoration_style_solid,
-                                  offset(m_text_decoration_style)));
-        m_text_decoration_color = get_color_property(el, _text_decoration_color_, propagate_decoration,
-                                                     web_color::current_color, offset(m_text_decoration_color));
-    } else
-    {
-        m_text_decoration_thickness = css_length::predef_value(text_decoration_thickness_auto);
-        m_text_decoration_color     = web_color::current_color;
-    }
-
-    // text-emphasis
-    m_text_emphasis_style =
-        el->get_property<std::string>(_text_emphasis_style_, true, "", offset(m_text_emphasis_style));
-    m_text_emphasis_position = el->get_property<int>(_text_emphasis_position_, true, text_emphasis_position_over,
-                                                     offset(m_text_emphasis_position));
-    m_text_emphasis_color =
-        get_color_property(el, _text_emphasis_color_, true, web_color::current_color, offset(m_text_emphasis_color));
-
-    if(el->parent())
-    {
-        if(m_text_emphasis_style.empty() || m_text_emphasis_style == "initial" || m_text_emphasis_style == "unset")
-        {
-            m_text_emphasis_style = el->parent()->css().get_text_emphasis_style();
-        }
-        if(m_text_emphasis_color == web_color::current_color)
-        {
-            m_text_emphasis_color = el->parent()->css().get_text_emphasis_color();
-        }
-        m_text_emphasis_position |= el->parent()->css().get_text_emphasis_position();
-    }
+    font->weight = el->get_property<css_length>(declared, _font_weight_, true, css_length::predef_value(font_weight_normal),
+                                                group_offset(m_font, css_font, weight));
+    font->style  = static_cast<font_style>(
+        el->get_property<int>(declared, _font_style_, true, font_style_normal, group_offset(m_font, css_font, style)));
 
-    if(m_font_weight.is_predefined())
+    if(font->weight.is_predefined())
     {
-        switch(m_font_weight.predef())
+        switch(font->weight.predef())
         {
         case font_weight_bold:
-            m_font_weight = 700;
+            font->weight = 700;
             break;
         case font_weight_bolder:
             {
-                const int inherited = static_cast<int>(el->parent()->css().m_font_weight.val());
+                const int inherited = static_cast<int>(el_parent->css().m_font->weight.val());
                 if(inherited < 400)
                 {
-                    m_font_weight = 400;
+                    font->weight = 400;
                 } else if(inherited >= 400 && inherited < 600)
                 {
-                    m_font_weight = 700;
+                    font->weight = 700;
                 } else
                 {
-                    m_font_weight = 900;
+                    font->weight = 900;
                 }
             }
             break;
         case font_weight_lighter:
             {
-                const int inherited = static_cast<int>(el->parent()->css().m_font_weight.val());
+                const int inherited = static_cast<int>(el_parent->css().m_font->weight.val());
                 if(inherited < 600)
                 {
-                    m_font_weight = 100;
+                    font->weight = 100;
                 } else if(inherited >= 600 && inherited < 800)
                 {
-                    m_font_weight = 400;
+                    font->weight = 400;
                 } else
                 {
-                    m_font_weight = 700;
+                    font->weight = 700;
                 }
             }
             break;
         default:
-            m_font_weight = 400;
+            font->weight = 400;
             break;
         }
     }
 
+    create_font(*font, doc);
+
+    const css_length normal = css_length::predef_value(0);
+    font->line_height.css_value =
+        el->get_property<css_length>(declared, _line_height_, true, normal, group_offset(m_font, css_font, line_height.css_value));
+    if(font->line_height.css_value.is_predefined())
+    {
+        font->line_height.computed_value = font->metrics.height;
+    } else if(font->line_height.css_value.units() == css_units_none)
+    {
+        font->line_height.computed_value = pixel_t(font->line_height.css_value.val() * font_size.value());
+    } else
+    {
+        font->line_height.computed_value =
+            doc->to_pixels(font->line_height.css_value, font->metrics, font->metrics.font_size);
+        font->line_height.css_value = static_cast<float>(font->line_height.computed_value);
+    }
+
+    m_font = std::move(font);
+}
+
+// The font is described by the font group and by the misc and text decoration groups of the element
+void litehtml::css_properties::create_font(css_font& font, const document::ptr& doc) const
+{
     font_description descr;
-    descr.family               = m_font_family;
-    descr.size                 = std::round(font_size.value());
-    descr.style                = m_font_style;
-    descr.weight               = static_cast<int>(m_font_weight.val());
-    descr.decoration_line      = m_text_decoration_line;
-    descr.decoration_thickness = m_text_decoration_thickness;
-    descr.decoration_style     = m_text_decoration_style;
-    descr.decoration_color     = m_text_decoration_color;
-    descr.emphasis_style       = m_text_emphasis_style;
-    descr.emphasis_color       = m_text_emphasis_color;
-    descr.emphasis_position    = m_text_emphasis_position;
-
-    m_font = doc->get_font(descr, &m_font_metrics);
+    descr.family               = m_misc->font_family;
+    descr.size                 = std::round(font.size.val());
+    descr.style                = font.style;
+    descr.weight               = static_cast<int>(font.weight.val());
+    descr.decoration_line      = m_text_decoration->line;
+    descr.decoration_thickness = m_text_decoration->thickness;
+    descr.decoration_style     = m_text_decoration->style;
+    descr.decoration_color     = m_text_decoration->color;
+    descr.emphasis_style       = m_text_decoration->emphasis_style;
+    descr.emphasis_color       = m_text_decoration->emphasis_color;
+    descr.emphasis_position    = m_text_decoration->emphasis_position;
+
+    font.font = doc->get_font(descr, &font.metrics);
 }
 
-void litehtml::css_properties::compute_background(const html_tag* el, const document::ptr& doc)
+void litehtml::css_properties::compute_misc(const html_tag* el, const style_index& declared, const document::ptr& doc)
 {
-    m_bg.m_color = get_color_property(el, _background_color_, false, web_color::transparent, offset(m_bg.m_color));
+    // font-family and cursor are inherited, content is not
+    auto* el_parent = el->parent_ptr();
+    if(el_parent && el_parent->css().m_misc->content.empty() &&
+       !declared.has_any_property({_font_family_, _cursor_, _content_}))
+    {
+        m_misc = el_parent->css().m_misc;
+        return;
+    }
 
-    const css_size auto_auto(css_length::predef_value(background_size_auto),
-                             css_length::predef_value(background_size_auto));
-    m_bg.m_position_x = el->get_property<length_vector>(
-        _background_position_x_, false, {css_length(0, css_units_percentage)}, offset(m_bg.m_position_x));
-    m_bg.m_position_y = el->get_property<length_vector>(
-        _background_position_y_, false, {css_length(0, css_units_percentage)}, offset(m_bg.m_position_y));
-    m_bg.m_size = el->get_property<size_vector>(_background_size_, false, {auto_auto}, offset(m_bg.m_size));
+    auto misc         = std::make_shared<css_misc>();
+    misc->font_family = el->get_property<std::string>(declared, _font_family_, true, doc->container()->get_default_font_name(),
+                                                      group_offset(m_misc, css_misc, font_family));
+    misc->cursor  = el->get_property<std::string>(declared, _cursor_, true, "auto", group_offset(m_misc, css_misc, cursor));
+    misc->content = el->get_property<std::string>(declared, _content_, false, "", group_offset(m_misc, css_misc, content));
+    m_misc        = std::move(misc);
+}
+
+void litehtml::css_properties::compute_text_decoration(const html_tag* el, const style_index& declared)
+{
+    bool propagate_decoration =
+        !is_one_of(m_display, display_inline_block, display_inline_table, display_inline_flex) &&
+        m_float == float_none && !is_one_of(m_el_position, element_position_absolute, element_position_fixed);
 
-    for(auto& x : m_bg.m_position_x)
+    // The propagated decoration and the inherited emphasis are the same as the parent ones, if the element doesn't
+    // set its own
+    auto* el_parent = el->parent_ptr();
+    if(el_parent && propagate_decoration &&
+       !declared.has_any_property({_text_decoration_line_, _text_decoration_thickness_, _text_decoration_style_,
+                              _text_decoration_color_, _text_emphasis_style_, _text_emphasis_position_,
+                              _text_emphasis_color_}))
     {
-        doc->cvt_units(x, m_font_metrics, 0_px);
+        m_text_decoration = el_parent->css().m_text_decoration;
+        return;
     }
-    for(auto& y : m_bg.m_position_y)
+
+    auto decoration  = std::make_shared<css_text_decoration>();
+    decoration->line = el->get_property<int>(declared, _text_decoration_line_, propagate_decoration, text_decoration_line_none,
+                                             group_offset(m_text_decoration, css_text_decoration, line));
+
+    // Merge parent text decoration with child text decoration
+    if(propagate_decoration && el_parent)
     {
-        doc->cvt_units(y, m_font_metrics, 0_px);
+        decoration->line |= el_parent->css().get_text_decoration_line();
     }
-    for(auto& size : m_bg.m_size)
+
+    if(decoration->line)
+    {
+        decoration->thickness = el->get_property<css_length>(declared, 
+            _text_decoration_thickness_, propagate_decoration, css_length::predef_value(text_decoration_thickness_auto),
+            group_offset(m_text_decoration, css_text_decoration, thickness));
+        decoration->style = static_cast<text_decoration_style>(
+            el->get_property<int>(declared, _text_decoration_style_, propagate_decoration, text_decoration_style_solid,
+                                  group_offset(m_text_decoration, css_text_decoration, style)));
+        decoration->color =
+            get_color_property(el, declared, _text_decoration_color_, propagate_decoration, web_color::current_color,
+                               group_offset(m_text_decoration, css_text_decoration, color));
+    } else
     {
-        doc->cvt_units(size.width, m_font_metrics, 0_px);
-        doc->cvt_units(size.height, m_font_metrics, 0_px);
+        decoration->thickness = css_length::predef_value(text_decoration_thickness_auto);
+        decoration->color     = web_color::current_color;
     }
 
-    m_bg.m_attachment = el->get_property<int_vector>(_background_attachment_, false, {background_attachment_scroll},
-                                                     offset(m_bg.m_attachment));
-    m_bg.m_repeat =
-        el->get_property<int_vector>(_background_repeat_, false, {background_repeat_repeat}, offset(m_bg.m_repeat));
-    m_bg.m_clip = el->get_property<int_vector>(_background_clip_, false, {background_box_border}, offset(m_bg.m_clip));
-    m_bg.m_origin =
-        el->get_property<int_vector>(_background_origin_, false, {background_box_padding}, offset(m_bg.m_origin));
+    // text-emphasis
+    decoration->emphasis_style = el->get_property<std::string>(declared, 
+        _text_emphasis_style_, true, "", group_offset(m_text_decoration, css_text_decoration, emphasis_style));
+    decoration->emphasis_position =
+        el->get_property<int>(declared, _text_emphasis_position_, true, text_emphasis_position_over,
+                              group_offset(m_text_decoration, css_text_decoration, emphasis_position));
+    decoration->emphasis_color =
+        get_color_property(el, declared, _text_emphasis_color_, true, web_color::current_color,
+                           group_offset(m_text_decoration, css_text_decoration, emphasis_color));
 
-    m_bg.m_image   = el->get_property<std::vector<image>>(_background_image_, false, {image()}, offset(m_bg.m_image));
-    m_bg.m_baseurl = el->get_property<std::string>(_background_image_baseurl_, false, "", offset(m_bg.m_baseurl));
+    if(el_parent)
+    {
+        if(decoration->emphasis_style.empty() || decoration->emphasis_style == "initial" ||
+           decoration->emphasis_style == "unset")
+        {
+            decoration->emphasis_style = el_parent->css().get_text_emphasis_style();
+        }
+        if(decoration->emphasis_color == web_color::current_color)
+        {
+            decoration->emphasis_color = el_parent->css().get_text_emphasis_color();
+        }
+        decoration->emphasis_position |= el_parent->css().get_text_emphasis_position();
+    }
+    m_text_decoration = std::move(decoration);
+}
+
+void litehtml::css_properties::compute_background(const html_tag* el, const style_index& declared,
+                                                  const document::ptr& doc)
+{
+    const css_size auto_auto(css_length::predef_value(background_size_auto),
+                             css_length::predef_value(background_size_auto));
+
+    // The background properties are not inherited, without them the background is initial
+    if(!declared.has_any_property({_background_color_, _background_position_x_, _background_position_y_, _background_size_,
+                              _background_attachment_, _background_repeat_, _background_clip_, _background_origin_,
+                              _background_image_, _background_image_baseurl_}))
+    {
+        static const std::shared_ptr<const background> initial_bg = [&auto_auto]
+        {
+            auto bg          = std::make_shared<background>();
+            bg->m_color      = web_color::transparent;
+            bg->m_position_x = {css_length(0, css_units_percentage)};
+            bg->m_position_y = {css_length(0, css_units_percentage)};
+            bg->m_size       = {auto_auto};
+            bg->m_attachment = {background_attachment_scroll};
+            bg->m_repeat     = {background_repeat_repeat};
+            bg->m_clip       = {background_box_border};
+            bg->m_origin     = {background_box_padding};
+            bg->m_image      = {image()};
+            return bg;
+        }();
+        m_bg = initial_bg;
+        return;
+    }
+
+    auto bg = std::make_shared<background>();
+
+    bg->m_color = get_color_property(el, declared, _background_color_, false, web_color::transparent,
+                                     group_offset(m_bg, background, m_color));
+
+    bg->m_position_x = el->get_property<length_vector>(declared, _background_position_x_, false,
+                                                       {css_length(0, css_units_percentage)},
+                                                       group_offset(m_bg, background, m_position_x));
+    bg->m_position_y = el->get_property<length_vector>(declared, _background_position_y_, false,
+                                                       {css_length(0, css_units_percentage)},
+                                                       group_offset(m_bg, background, m_position_y));
+    bg->m_size =
+        el->get_property<size_vector>(declared, _background_size_, false, {auto_auto}, group_offset(m_bg, background, m_size));
+
+    for(auto& x : bg->m_position_x)
+    {
+        doc->cvt_units(x, m_font->metrics, 0_px);
+    }
+    for(auto& y : bg->m_position_y)
+    {
+        doc->cvt_units(y, m_font->metrics, 0_px);
+    }
+    for(auto& size : bg->m_size)
+    {
+        doc->cvt_units(size.width, m_font->metrics, 0_px);
+        doc->cvt_units(size.height, m_font->metrics, 0_px);
+    }
 
-    for(auto& image : m_bg.m_image)
+    bg->m_attachment = el->get_property<int_vector>(declared, _background_attachment_, false, {background_attachment_scroll},
+                                                    group_offset(m_bg, background, m_attachment));
+    bg->m_repeat     = el->get_property<int_vector>(declared, _background_repeat_, false, {background_repeat_repeat},
+                                                    group_offset(m_bg, background, m_repeat));
+    bg->m_clip       = el->get_property<int_vector>(declared, _background_clip_, false, {background_box_border},
+                                                    group_offset(m_bg, background, m_clip));
+    bg->m_origin     = el->get_property<int_vector>(declared, _background_origin_, false, {background_box_padding},
+                                                    group_offset(m_bg, background, m_origin));
+
+    bg->m_image   = el->get_property<std::vector<image>>(declared, _background_image_, false, {image()},
+                                                         group_offset(m_bg, background, m_image));
+    bg->m_baseurl = el->get_property<std::string>(declared, _background_image_baseurl_, false, "",
+                                                  group_offset(m_bg, background, m_baseurl));
+
+    for(auto& image : bg->m_image)
     {
         switch(image.type)
         {
@@ -561,7 +677,7 @@ void litehtml::css_properties::compute_background(const html_tag* el, const docu
         case image::type_url:
             if(!image.url.empty())
             {
-                doc->container()->load_image(image.url.c_str(), m_bg.m_baseurl.c_str(), true);
+                doc->container()->load_image(image.url.c_str(), bg->m_baseurl.c_str(), true);
             }
             break;
         case image::type_gradient:
@@ -569,46 +685,58 @@ void litehtml::css_properties::compute_background(const html_tag* el, const docu
             {
                 if(item.length)
                 {
-                    doc->cvt_units(*item.length, m_font_metrics, 0_px);
+                    doc->cvt_units(*item.length, m_font->metrics, 0_px);
                 }
             }
             break;
         }
     }
+    m_bg = std::move(bg);
 }
 
-void litehtml::css_properties::compute_flex(const html_tag* el, const document::ptr& doc)
+void litehtml::css_properties::compute_flex(const html_tag* el, const style_index& declared, const document::ptr& doc)
 {
-    if(m_display == display_flex || m_display == display_inline_flex)
-    {
-        m_flex_direction = static_cast<flex_direction>(
-            el->get_property<int>(_flex_direction_, false, flex_direction_row, offset(m_flex_direction)));
-        m_flex_wrap =
-            static_cast<flex_wrap>(el->get_property<int>(_flex_wrap_, false, flex_wrap_nowrap, offset(m_flex_wrap)));
-
-        m_flex_justify_content = static_cast<flex_justify_content>(el->get_property<int>(
-            _justify_content_, false, flex_justify_content_flex_start, offset(m_flex_justify_content)));
-        m_flex_align_items     = static_cast<flex_align_items>(
-            el->get_property<int>(_align_items_, false, flex_align_items_normal, offset(m_flex_align_items)));
-        m_flex_align_content = static_cast<flex_align_content>(
-            el->get_property<int>(_align_content_, false, flex_align_content_stretch, offset(m_flex_align_content)));
+    auto* parent         = el->parent_ptr();
+    bool  flex_container = m_display == display_flex || m_display == display_inline_flex;
+    bool  flex_item =
+        parent && (parent->css().m_display == display_flex || parent->css().m_display == display_inline_flex);
+
+    // The flex properties are not inherited, they are initial for the most elements
+    if(!flex_container && !flex_item && !declared.has_any_property({_align_self_, _order_}))
+    {
+        m_flex = initial_group<css_flex>();
+        return;
+    }
+
+    auto flex = std::make_shared<css_flex>();
+    if(flex_container)
+    {
+        flex->direction       = static_cast<flex_direction>(el->get_property<int>(declared, 
+            _flex_direction_, false, flex_direction_row, group_offset(m_flex, css_flex, direction)));
+        flex->wrap            = static_cast<flex_wrap>(
+            el->get_property<int>(declared, _flex_wrap_, false, flex_wrap_nowrap, group_offset(m_flex, css_flex, wrap)));
+        flex->justify_content = static_cast<flex_justify_content>(el->get_property<int>(declared, 
+            _justify_content_, false, flex_justify_content_flex_start, group_offset(m_flex, css_flex, justify_content)));
+        flex->align_items     = static_cast<flex_align_items>(el->get_property<int>(declared, 
+            _align_items_, false, flex_align_items_normal, group_offset(m_flex, css_flex, align_items)));
+        flex->align_content   = static_cast<flex_align_content>(el->get_property<int>(declared, 
+            _align_content_, false, flex_align_content_stretch, group_offset(m_flex, css_flex, align_content)));
     }
-    m_flex_align_self = static_cast<flex_align_items>(
-        el->get_property<int>(_align_self_, false, flex_align_items_auto, offset(m_flex_align_self)));
-    auto parent = el->parent();
-    if(parent && (parent->css().m_display == display_flex || parent->css().m_display == display_inline_flex))
-    {
-        m_flex_grow   = el->get_property<float>(_flex_grow_, false, 0, offset(m_flex_grow));
-        m_flex_shrink = el->get_property<float>(_flex_shrink_, false, 1, offset(m_flex_shrink));
-        m_flex_basis  = el->get_property<css_length>(_flex_basis_, false, css_length::predef_value(flex_basis_auto),
-                                                     offset(m_flex_basis));
-        if(!m_flex_basis.is_predefined() && m_flex_basis.units() == css_units_none &&
-           pixel_t(m_flex_basis.val()) != 0_px)
+    flex->align_self = static_cast<flex_align_items>(
+        el->get_property<int>(declared, _align_self_, false, flex_align_items_auto, group_offset(m_flex, css_flex, align_self)));
+    flex->order      = el->get_property<int>(declared, _order_, false, 0, group_offset(m_flex, css_flex, order));
+    if(flex_item)
+    {
+        flex->grow   = el->get_property<float>(declared, _flex_grow_, false, 0, group_offset(m_flex, css_flex, grow));
+        flex->shrink = el->get_property<float>(declared, _flex_shrink_, false, 1, group_offset(m_flex, css_flex, shrink));
+        flex->basis  = el->get_property<css_length>(declared, _flex_basis_, false, css_length::predef_value(flex_basis_auto),
+                                                    group_offset(m_flex, css_flex, basis));
+        if(!flex->basis.is_predefined() && flex->basis.units() == css_units_none && pixel_t(flex->basis.val()) != 0_px)
         {
             // flex-basis property must contain units
-            m_flex_basis.predef(flex_basis_auto);
+            flex->basis.predef(flex_basis_auto);
         }
-        doc->cvt_units(m_flex_basis, m_font_metrics, 0_px);
+        doc->cvt_units(flex->basis, m_font->metrics, 0_px);
         if(m_display == display_inline || m_display == display_inline_block)
         {
             m_display = display_block;
@@ -620,6 +748,7 @@ void litehtml::css_properties::compute_flex(const html_tag* el, const document::
             m_display = display_flex;
         }
     }
+    m_flex = std::move(flex);
 }
 
 // https://www.w3.org/TR/css-values-4/#snap-a-length-as-a-border-width
@@ -630,7 +759,7 @@ void litehtml::css_properties::snap_border_width(css_length& width, const std::s
         return;
     }
 
-    pixel_t px = doc->to_pixels(width, m_font_metrics, 0_px);
+    pixel_t px = doc->to_pixels(width, m_font->metrics, 0_px);
 
     if(px > 0_px && px < 1_px)
     {
@@ -643,6 +772,407 @@ void litehtml::css_properties::snap_border_width(css_length& width, const std::s
     width.set_value(px.value(), css_units_px);
 }
 
+template <class Props, class Fn> void litehtml::css_properties::for_each_value(Props& props, Fn&& fn)
+{
+    fn(props.m_el_position);
+    fn(props.m_text_align);
+    fn(props.m_overflow);
+    fn(props.m_white_space);
+    fn(props.m_display);
+    fn(props.m_visibility);
+    fn(props.m_appearance);
+    fn(props.m_box_sizing);
+    fn(props.m_vertical_align);
+    fn(props.m_float);
+    fn(props.m_clear);
+    fn(props.m_text_transform);
+    fn(props.m_border_collapse);
+    fn(props.m_caption_side);
+    fn(props.m_z_index);
+    fn(props.m_css_margins);
+    fn(props.m_css_padding);
+    fn(props.m_css_borders);
+    fn(props.m_css_width);
+    fn(props.m_css_height);
+    fn(props.m_css_min_width);
+    fn(props.m_css_min_height);
+    fn(props.m_css_max_width);
+    fn(props.m_css_max_height);
+    fn(props.m_css_offsets);
+    fn(props.m_css_text_indent);
+    fn(props.m_css_border_spacing_x);
+    fn(props.m_css_border_spacing_y);
+    fn(props.m_color);
+}
+
+namespace litehtml
+{
+    template <> struct snapshot_enum<element_position> : snapshot_enum_count<element_position, element_position_fixed + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<text_align> : snapshot_enum_count<text_align, text_align_justify + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<overflow> : snapshot_enum_count<overflow, overflow_no_content + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<white_space> : snapshot_enum_count<white_space, white_space_pre_wrap + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<style_display> : snapshot_enum_count<style_display, display_inline_flex + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<visibility> : snapshot_enum_count<visibility, visibility_collapse + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<appearance> : snapshot_enum_count<appearance, appearance_textarea + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<box_sizing> : snapshot_enum_count<box_sizing, box_sizing_border_box + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<vertical_align> : snapshot_enum_count<vertical_align, va_text_bottom + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<element_float> : snapshot_enum_count<element_float, float_right + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<element_clear> : snapshot_enum_count<element_clear, clear_both + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<text_transform> : snapshot_enum_count<text_transform, text_transform_lowercase + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<border_collapse> : snapshot_enum_count<border_collapse, border_collapse_separate + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<caption_side> : snapshot_enum_count<caption_side, caption_side_bottom + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<border_style> : snapshot_enum_count<border_style, border_style_outset + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<radial_shape_t> : snapshot_enum_count<radial_shape_t, radial_shape_ellipse + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<radial_extent_t> : snapshot_enum_count<radial_extent_t, radial_extent_farthest_side + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<color_space_t> : snapshot_enum_count<color_space_t, color_space_oklch + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<hue_interpolation_t> : snapshot_enum_count<hue_interpolation_t, hue_interpolation_decreasing + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<enum image::type> : snapshot_enum_count<enum image::type, image::type_gradient + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<list_style_type> : snapshot_enum_count<list_style_type, list_style_type_upper_roman + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<list_style_position> : snapshot_enum_count<list_style_position, list_style_position_outside + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<text_decoration_style> : snapshot_enum_count<text_decoration_style, text_decoration_style_wavy + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<flex_direction> : snapshot_enum_count<flex_direction, flex_direction_column_reverse + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<flex_wrap> : snapshot_enum_count<flex_wrap, flex_wrap_wrap_reverse + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<flex_justify_content> : snapshot_enum_count<flex_justify_content, flex_justify_content_stretch + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<flex_align_content> : snapshot_enum_count<flex_align_content, flex_align_content_stretch + 1>
+    {
+    };
+
+    template <> struct snapshot_enum<font_style> : snapshot_enum_count<font_style, font_style_italic + 1>
+    {
+    };
+
+    // A keyword with the first/last/safe/unsafe flags
+    template <> struct snapshot_enum<flex_align_items>
+    {
+        static bool is_valid(std::underlying_type_t<flex_align_items> val)
+        {
+            const unsigned flags = flex_align_items_first | flex_align_items_last | flex_align_items_unsafe |
+                                   flex_align_items_safe;
+            return (static_cast<unsigned>(val) & ~flags) <= flex_align_items_flex_end;
+        }
+    };
+
+    // Only the gradient type is stored as a string_id
+    template <> struct snapshot_enum<string_id>
+    {
+        static bool is_valid(std::underlying_type_t<string_id> val)
+        {
+            return val == empty_id || (val >= _linear_gradient_ && val <= _repeating_conic_gradient_);
+        }
+    };
+
+    template <> struct snapshot_fields<web_color>
+    {
+        static constexpr auto fields = std::make_tuple(&web_color::red, &web_color::green, &web_color::blue,
+                                                       &web_color::alpha, &web_color::is_current_color);
+    };
+
+    template <> struct snapshot_fields<css_margins>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&css_margins::left, &css_margins::right, &css_margins::top, &css_margins::bottom);
+    };
+
+    template <> struct snapshot_fields<css_offsets>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&css_offsets::left, &css_offsets::top, &css_offsets::right, &css_offsets::bottom);
+    };
+
+    template <> struct snapshot_fields<css_border>
+    {
+        static constexpr auto fields = std::make_tuple(&css_border::width, &css_border::style, &css_border::color);
+    };
+
+    template <> struct snapshot_fields<css_border_radius>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&css_border_radius::top_left_x, &css_border_radius::top_left_y,
+                            &css_border_radius::top_right_x, &css_border_radius::top_right_y,
+                            &css_border_radius::bottom_right_x, &css_border_radius::bottom_right_y,
+                            &css_border_radius::bottom_left_x, &css_border_radius::bottom_left_y);
+    };
+
+    template <> struct snapshot_fields<css_borders>
+    {
+        static constexpr auto fields = std::make_tuple(&css_borders::left, &css_borders::top, &css_borders::right,
+                                                       &css_borders::bottom, &css_borders::radius);
+    };
+
+    template <> struct snapshot_fields<css_size>
+    {
+        static constexpr auto fields = std::make_tuple(&css_size::width, &css_size::height);
+    };
+
+    template <> struct snapshot_fields<gradient::color_stop>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&gradient::color_stop::is_color_hint, &gradient::color_stop::color,
+                            &gradient::color_stop::length, &gradient::color_stop::angle);
+    };
+
+    template <> struct snapshot_fields<gradient>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&gradient::m_type, &gradient::m_side, &gradient::angle, &gradient::m_colors,
+                            &gradient::position_x, &gradient::position_y, &gradient::radial_shape,
+                            &gradient::radial_extent, &gradient::radial_radius_x, &gradient::radial_radius_y,
+                            &gradient::conic_from_angle, &gradient::color_space, &gradient::hue_interpolation);
+    };
+
+    template <> struct snapshot_fields<image>
+    {
+        static constexpr auto fields = std::make_tuple(&image::type, &image::url, &image::m_gradient);
+    };
+
+    template <> struct snapshot_fields<background>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&background::m_image, &background::m_baseurl, &background::m_color,
+                            &background::m_attachment, &background::m_position_x, &background::m_position_y,
+                            &background::m_size, &background::m_repeat, &background::m_clip, &background::m_origin);
+    };
+
+    template <> struct snapshot_fields<css_list_style>
+    {
+        static constexpr auto fields = std::make_tuple(&css_list_style::type, &css_list_style::position,
+                                                       &css_list_style::image, &css_list_style::image_baseurl);
+    };
+
+    template <> struct snapshot_fields<css_text_decoration>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&css_text_decoration::line, &css_text_decoration::style, &css_text_decoration::thickness,
+                            &css_text_decoration::color, &css_text_decoration::emphasis_style,
+                            &css_text_decoration::emphasis_color, &css_text_decoration::emphasis_position);
+    };
+
+    template <> struct snapshot_fields<css_flex>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&css_flex::grow, &css_flex::shrink, &css_flex::basis, &css_flex::direction,
+                            &css_flex::wrap, &css_flex::justify_content, &css_flex::align_items, &css_flex::align_self,
+                            &css_flex::align_content, &css_flex::order);
+    };
+
+    template <> struct snapshot_fields<css_misc>
+    {
+        static constexpr auto fields = std::make_tuple(&css_misc::font_family, &css_misc::cursor, &css_misc::content);
+    };
+
+    template <> struct snapshot_fields<css_line_height_t>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&css_line_height_t::css_value, &css_line_height_t::computed_value);
+    };
+
+    // The font handle and the metrics belong to the container, the font is created again on reading
+    template <> struct snapshot_fields<css_font>
+    {
+        static constexpr auto fields =
+            std::make_tuple(&css_font::size, &css_font::weight, &css_font::style, &css_font::line_height);
+    };
+} // namespace litehtml
+
+void litehtml::css_properties::write(snapshot_writer& out) const
+{
+    // Many elements have the same values, they are written as a block shared with the other elements
+    std::string      values;
+    snapshot_writer values_out(values);
+    for_each_value(*this, [&values_out](const auto& val) { values_out.write(val); });
+    out.write_block(values);
+
+    out.write_group(m_bg, initial_group<background>(), [&out](const background& bg) { out.write(bg); });
+    out.write_group(m_list_style, initial_group<css_list_style>(),
+                    [&out](const css_list_style& list_style) { out.write(list_style); });
+    // The font is created from the font, misc and text decoration groups on reading, so the font group goes last
+    out.write_group(m_text_decoration, initial_group<css_text_decoration>(),
+                    [&out](const css_text_decoration& decoration) { out.write(decoration); });
+    out.write_group(m_flex, initial_group<css_flex>(), [&out](const css_flex& flex) { out.write(flex); });
+    out.write_group(m_misc, initial_group<css_misc>(), [&out](const css_misc& misc) { out.write(misc); });
+    out.write_group(m_font, initial_group<css_font>(), [&out](const css_font& font) { out.write(font); });
+}
+
+bool litehtml::css_properties::read(snapshot_reader& reader, const document::ptr& doc)
+{
+    snapshot_reader values(nullptr, 0);
+    bool            ok = reader.read_block(values);
+    for_each_value(*this, [&values, &ok](auto& val) { ok = ok && values.read(val); });
+    if(!ok)
+    {
+        return false;
+    }
+
+    auto read_bg = [&reader, &doc](background& bg)
+    {
+        // The keywords of the layers are kept as ints, they are checked like the enums
+        auto in_range = [](const int_vector& vals, int count)
+        { return std::all_of(vals.begin(), vals.end(), [count](int val) { return val >= 0 && val < count; }); };
+        if(!reader.read(bg) || !in_range(bg.m_attachment, background_attachment_fixed + 1) ||
+           !in_range(bg.m_repeat, background_repeat_no_repeat + 1) ||
+           !in_range(bg.m_clip, background_box_content + 1) || !in_range(bg.m_origin, background_box_content + 1))
+        {
+            return false;
+        }
+        for(const auto& img : bg.m_image)
+        {
+            if(img.type == image::type_url && !img.url.empty())
+            {
+                doc->container()->load_image(img.url.c_str(), bg.m_baseurl.c_str(), true);
+            }
+        }
+        return true;
+    };
+    auto read_list_style = [&reader, &doc](css_list_style& list_style)
+    {
+        if(!reader.read(list_style))
+        {
+            return false;
+        }
+        if(!list_style.image.empty())
+        {
+            doc->container()->load_image(list_style.image.c_str(), list_style.image_baseurl.c_str(), true);
+        }
+        return true;
+    };
+    auto read_font = [this, &reader, &doc](css_font& font)
+    {
+        if(!reader.read(font))
+        {
+            return false;
+        }
+        create_font(font, doc);
+        // The normal line height depends on the font, the other values are kept in pixels
+        if(font.line_height.css_value.is_predefined())
+        {
+            font.line_height.computed_value = font.metrics.height;
+        }
+        return true;
+    };
+    auto read_group = [&reader](auto& group) { return reader.read(group); };
+
+    return reader.read_group(m_bg, initial_group<background>(), read_bg) &&
+           reader.read_group(m_list_style, initial_group<css_list_style>(), read_list_style) &&
+           reader.read_group(m_text_decoration, initial_group<css_text_decoration>(), read_group) &&
+           reader.read_group(m_flex, initial_group<css_flex>(), read_group) &&
+           reader.read_group(m_misc, initial_group<css_misc>(), read_group) &&
+           reader.read_group(m_font, initial_group<css_font>(), read_font);
+}
+
+void litehtml::css_properties::get_memory_usage(memory_usage_info& usage) const
+{
+    usage.styles += sizeof(css_properties);
+
+    // Adds the group and the memory it owns, if the group is not counted yet
+    auto add_group = [&usage](const auto& group, auto&& owned_memory)
+    {
+        if(usage.groups.insert(group.get()).second)
+        {
+            usage.styles += sizeof(*group) + owned_memory(*group);
+        }
+    };
+    add_group(m_bg,
+              [](const background& bg)
+              {
+                  size_t ret = bg.m_image.capacity() * sizeof(image) + bg.m_baseurl.capacity() +
+                               (bg.m_attachment.capacity() + bg.m_repeat.capacity() + bg.m_clip.capacity() +
+                                bg.m_origin.capacity()) * sizeof(int) +
+                               (bg.m_position_x.capacity() + bg.m_position_y.capacity()) * sizeof(css_length) +
+                               bg.m_size.capacity() * sizeof(css_size);
+                  for(const auto& img : bg.m_image)
+                  {
+                      ret += img.url.capacity() + img.m_gradient.m_colors.capacity() * sizeof(gradient::color_stop);
+                  }
+                  return ret;
+              });
+    add_group(m_list_style, [](const css_list_style& list_style)
+              { return list_style.image.capacity() + list_style.image_baseurl.capacity(); });
+    add_group(m_text_decoration,
+              [](const css_text_decoration& decoration) { return decoration.emphasis_style.capacity(); });
+    add_group(m_flex, [](const css_flex&) { return size_t(0); });
+    add_group(m_misc, [](const css_misc& misc)
+              { return misc.font_family.capacity() + misc.cursor.capacity() + misc.content.capacity(); });
+    add_group(m_font, [](const css_font&) { return size_t(0); });
+}
+
 std::vector<std::tuple<std::string, std::string>> litehtml::css_properties::dump_get_attrs()
 {
     std::vector<std::tuple<std::string, std::string>> ret;
@@ -650,7 +1180,7 @@ std::vector<std::tuple<std::string, std::string>> litehtml::css_properties::dump
     ret.emplace_back("display", css_values(style_display_strings).value_by_index(m_display));
     ret.emplace_back("el_position", css_values(element_position_strings).value_by_index(m_el_position));
     ret.emplace_back("text_align", css_values(text_align_strings).value_by_index(m_text_align));
-    ret.emplace_back("font_size", m_font_size.to_string());
+    ret.emplace_back("font_size", m_font->size.to_string());
     ret.emplace_back("overflow", css_values(overflow_strings).value_by_index(m_overflow));
     ret.emplace_back("white_space", css_values(white_space_strings).value_by_index(m_white_space));
     ret.emplace_back("visibility", css_values(visibility_strings).value_by_index(m_visibility));
@@ -671,10 +1201,10 @@ std::vector<std::tuple<std::string, std::string>> litehtml::css_properties::dump
     ret.emplace_back("max_height", m_css_max_width.to_string());
     ret.emplace_back("offsets", m_css_offsets.to_string());
     ret.emplace_back("text_indent", m_css_text_indent.to_string());
-    ret.emplace_back("line_height", std::to_string(m_line_height.computed_value.value()));
-    ret.emplace_back("list_style_type", css_values(list_style_type_strings).value_by_index(m_list_style_type));
+    ret.emplace_back("line_height", std::to_string(m_font->line_height.computed_value.value()));
+    ret.emplace_back("list_style_type", css_values(list_style_type_strings).value_by_index(m_list_style->type));
     ret.emplace_back("list_style_position",
-                     css_values(list_style_position_strings).value_by_index(m_list_style_position));
+                     css_values(list_style_position_strings).value_by_index(m_list_style->position));
     ret.emplace_back("border_spacing_x", m_css_border_spacing_x.to_string());
     ret.emplace_back("border_spacing_y", m_css_border_spacing_y.to_string());
 
@@ -16,7 +16,7 @@ namespace litehtml
         {
             return "";
         }
-        return name().substr(0, 2) == "--" ? name() : lowcase(name());
+        return name().compare(0, 2, "--") == 0 ? name() : lowcase(name());
     }
 
     char mirror(char c)
@@ -636,7 +636,7 @@ namespace litehtml
 
         // If string’s value is an ASCII case-insensitive match for "url", and the next input code point is
         // U+0028 ((), consume it.
-        if(lowcase(string) == "url" && str[index] == '(')
+        if(str[index] == '(' && t_strcasecmp(string.c_str(), "url") == 0)
         {
             index++; // consume '('
 
@@ -653,7 +653,7 @@ namespace litehtml
                 {
                     index--;
                 }
-                return {FUNCTION, string};
+                return {FUNCTION, std::move(string)};
             }
             // Otherwise, consume a url token, and return it.
             return consume_url_token();
@@ -664,11 +664,11 @@ namespace litehtml
         if(str[index] == '(')
         {
             index++;
-            return {FUNCTION, string};
+            return {FUNCTION, std::move(string)};
         }
 
         // Otherwise, create an <ident-token> with its value set to string and return it.
-        return {IDENT, string};
+        return {IDENT, std::move(string)};
     }
 
     // https://www.w3.org/TR/css-syntax-3/#consume-token
@@ -845,7 +845,7 @@ namespace litehtml
             {
                 break;
             }
-            tokens.push_back(token);
+            tokens.push_back(std::move(token));
         }
         return tokens;
     }
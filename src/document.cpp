@@ -3,6 +3,7 @@
 #include "document_container.h"
 #include "el_anchor.h"
 #include "el_base.h"
+#include "el_before_after.h"
 #include "el_body.h"
 #include "el_break.h"
 #include "el_cdata.h"
@@ -25,8 +26,11 @@
 #include "render_block.h"
 #include "render_item.h"
 #include "render_table.h"
+#include "snapshot.h"
 #include "stylesheet.h"
+#include "stylesheet_cache.h"
 #include "types.h"
+#include <atomic>
 
 namespace litehtml
 {
@@ -34,6 +38,9 @@ namespace litehtml
     document::document(document_container* container)
     {
         m_container = container;
+#ifdef LITEHTML_NODE_ARENA
+        m_arena = std::make_shared<node_arena>();
+#endif
     }
 
     document::~document()
@@ -54,8 +61,10 @@ namespace litehtml
         // Create litehtml::document
         document::ptr doc = std::make_shared<document>(container);
 
-        // Parse document into GumboOutput
-        GumboOutput* output = doc->parse_html(str);
+        // Parse document into GumboOutput. Gumbo keeps pointers into the parsed text, which are accessed in
+        // gumbo_tag_from_original_text, so the text must live until the elements are created.
+        std::string  text;
+        GumboOutput* output = doc->parse_html(str, text);
 
         // mode must be set before doc->create_node because it is used in html_tag::set_attr
         switch(output->document->v.document.doc_type_quirks_mode)
@@ -73,7 +82,7 @@ namespace litehtml
 
         // Create litehtml::elements.
         elements_list root_elements;
-        doc->create_node(output->root, root_elements, true, true);
+        doc->create_node(output->root, nullptr, root_elements, true, true);
         element::ptr root;
         if(!root_elements.empty())
         {
@@ -82,6 +91,8 @@ namespace litehtml
 
         // Destroy GumboOutput
         gumbo_destroy_output(&kGumboDefaultOptions, output);
+        // The elements keep copies of everything they need from the source
+        std::string().swap(text);
 
         doc->finalize_from_external_root(root, master_styles, user_styles);
 
@@ -110,12 +121,12 @@ namespace litehtml
 
         if(master_styles != "")
         {
-            m_master_css.parse_css_stylesheet(master_styles, "", shared_from_this());
+            stylesheet_cache::instance().parse_css_stylesheet(m_master_css, master_styles, "", shared_from_this());
             m_master_css.sort_selectors();
         }
         if(user_styles != "")
         {
-            m_user_css.parse_css_stylesheet(user_styles, "", shared_from_this());
+            stylesheet_cache::instance().parse_css_stylesheet(m_user_css, user_styles, "", shared_from_this());
             m_user_css.sort_selectors();
         }
 
@@ -142,7 +153,8 @@ namespace litehtml
                     media        = std::make_shared<media_query_list_list>();
                     media->add(mq_list);
                 }
-                m_styles.parse_css_stylesheet(css.text, css.baseurl, shared_from_this(), media);
+                stylesheet_cache::instance().parse_css_stylesheet(m_styles, css.text, css.baseurl, shared_from_this(),
+                                                                  media);
             }
             // Sort css selectors using CSS rules.
             m_styles.sort_selectors();
@@ -255,26 +267,33 @@ namespace litehtml
         return encoding::null;
     }
 
+    // Number of documents parsed again because of <meta> encoding, see document::reparse_count
+    static std::atomic<size_t> g_reparse_count{0};
+
+    size_t document::reparse_count()
+    {
+        return g_reparse_count;
+    }
+
     // substitute for gumbo_parse that handles encodings
-    GumboOutput* document::parse_html(estring str)
+    // The decoded source is stored in text, it must live until the output is destroyed.
+    GumboOutput* document::parse_html(estring str, std::string& text)
     {
         // https://html.spec.whatwg.org/multipage/parsing.html#the-input-byte-stream
         encoding_sniffing_algorithm(str);
-        // cannot store output in local variable because gumbo keeps pointers into it,
-        // which will be accessed later in gumbo_tag_from_original_text
         if(str.encoding == encoding::utf_8)
         {
-            m_text = str;
+            text = str;
         } else
         {
-            decode(str, str.encoding, m_text);
+            decode(str, str.encoding, text);
         }
 
         // Gumbo does not support callbacks on node creation, so we cannot change encoding while parsing.
         // Instead, we parse entire file and then handle <meta> tags.
 
-        // Using gumbo_parse_with_options to pass string length (m_text may contain NUL chars).
-        GumboOutput* output = gumbo_parse_with_options(&kGumboDefaultOptions, m_text.data(), m_text.size());
+        // Using gumbo_parse_with_options to pass string length (text may contain NUL chars).
+        GumboOutput* output = gumbo_parse_with_options(&kGumboDefaultOptions, text.data(), text.size());
 
         if(str.confidence == confidence::certain)
         {
@@ -292,78 +311,199 @@ namespace litehtml
             if(new_encoding != str.encoding)
             {
                 // ...reparse with the new encoding.
+                g_reparse_count++;
                 gumbo_destroy_output(&kGumboDefaultOptions, output);
-                m_text.clear();
+                text.clear();
 
                 if(new_encoding == encoding::utf_8)
                 {
-                    m_text = str;
+                    text = str;
                 } else
                 {
-                    decode(str, new_encoding, m_text);
+                    decode(str, new_encoding, text);
                 }
-                output = gumbo_parse_with_options(&kGumboDefaultOptions, m_text.data(), m_text.size());
+                output = gumbo_parse_with_options(&kGumboDefaultOptions, text.data(), text.size());
             }
         }
 
         return output;
     }
 
-    void document::create_node(void* gnode, elements_list& elements, bool parseTextNode, bool process_root)
+    namespace
+    {
+        // Creates the element class implementing the tag. Unknown tags are created as html_tag.
+        element::ptr create_tag_element(GumboTag tag, const document::ptr& doc)
+        {
+            switch(tag)
+            {
+            case GUMBO_TAG_BR:
+                return make_node<el_break>(doc->arena(), doc);
+            case GUMBO_TAG_P:
+                return make_node<el_para>(doc->arena(), doc);
+            case GUMBO_TAG_IMG:
+                return make_node<el_image>(doc->arena(), doc);
+            case GUMBO_TAG_TABLE:
+                return make_node<el_table>(doc->arena(), doc);
+            case GUMBO_TAG_TD:
+            case GUMBO_TAG_TH:
+                return make_node<el_td>(doc->arena(), doc);
+            case GUMBO_TAG_LINK:
+                return make_node<el_link>(doc->arena(), doc);
+            case GUMBO_TAG_TITLE:
+                return make_node<el_title>(doc->arena(), doc);
+            case GUMBO_TAG_A:
+                return make_node<el_anchor>(doc->arena(), doc);
+            case GUMBO_TAG_TR:
+                return make_node<el_tr>(doc->arena(), doc);
+            case GUMBO_TAG_STYLE:
+                return make_node<el_style>(doc->arena(), doc);
+            case GUMBO_TAG_BASE:
+                return make_node<el_base>(doc->arena(), doc);
+            case GUMBO_TAG_BODY:
+                return make_node<el_body>(doc->arena(), doc);
+            case GUMBO_TAG_DIV:
+                return make_node<el_div>(doc->arena(), doc);
+            case GUMBO_TAG_SCRIPT:
+                return make_node<el_script>(doc->arena(), doc);
+            case GUMBO_TAG_FONT:
+                return make_node<el_font>(doc->arena(), doc);
+            default:
+                return make_node<html_tag>(doc->arena(), doc);
+            }
+        }
+
+        // The attributes in the order of the snapshot, see read_node
+        using attribute_list = std::vector<std::pair<std::string, std::string>>;
+
+        template <class Func> void for_each_attribute(const string_map& attributes, Func func)
+        {
+            for(const auto& attribute : attributes)
+            {
+                func(attribute.first.c_str(), attribute.second.c_str());
+            }
+        }
+
+        template <class Func> void for_each_attribute(const GumboVector& attributes, Func func)
+        {
+            for(unsigned int i = 0; i < attributes.length; i++)
+            {
+                auto* attr = static_cast<GumboAttribute*>(attributes.data[i]);
+                func(attr->name, attr->value);
+            }
+        }
+
+        template <class Func> void for_each_attribute(const attribute_list& attributes, Func func)
+        {
+            for(const auto& attribute : attributes)
+            {
+                func(attribute.first.c_str(), attribute.second.c_str());
+            }
+        }
+
+        element::ptr create_container_element(document_container* container, const document::ptr& doc,
+                                              const char* tag_name, const string_map& attributes)
+        {
+            return container->create_element(tag_name, attributes, doc);
+        }
+
+        template <class Attributes>
+        element::ptr create_container_element(document_container* container, const document::ptr& doc,
+                                              const char* tag_name, const Attributes& attributes)
+        {
+            string_map attrs;
+            for_each_attribute(attributes,
+                               [&attrs](const char* name, const char* value) { attrs.insert_or_assign(name, value); });
+            return container->create_element(tag_name, attrs, doc);
+        }
+
+        GumboTag tag_from_name(const char* tag_name)
+        {
+            GumboTag tag = gumbo_tag_enum(tag_name);
+            // gumbo_tag_enum ignores case, but the tag names are matched case-sensitively here
+            if(tag != GUMBO_TAG_UNKNOWN && strcmp(gumbo_normalized_tagname(tag), tag_name) != 0)
+            {
+                tag = GUMBO_TAG_UNKNOWN;
+            }
+            return tag;
+        }
+
+        // Creates the element by the container or the element class implementing the tag, then sets the tag name
+        // and the attributes.
+        template <class Attributes>
+        element::ptr create_element(const document::ptr& doc, GumboTag tag, const char* tag_name,
+                                    const Attributes& attributes)
+        {
+            element::ptr        ret;
+            document_container* container = doc->container();
+            if(container && container->creates_elements())
+            {
+                ret = create_container_element(container, doc, tag_name, attributes);
+            }
+            if(!ret)
+            {
+                ret = create_tag_element(tag, doc);
+            }
+            ret->set_tagName(tag_name);
+            for_each_attribute(attributes, [&ret](const char* name, const char* value) {
+                ret->set_attr(name, value);
+            });
+            return ret;
+        }
+    } // namespace
+
+    void document::create_node(void* gnode, const element::ptr& parent, elements_list& elements, bool parseTextNode,
+                               bool process_root)
     {
         auto* node = static_cast<GumboNode*>(gnode);
+        // The created nodes are appended to the parent directly, the list is used for the top level nodes only
+        auto add_node = [&parent, &elements](const element::ptr& el) {
+            if(parent)
+            {
+                parent->appendChild(el);
+            } else
+            {
+                elements.push_back(el);
+            }
+        };
+
         switch(node->type)
         {
         case GUMBO_NODE_ELEMENT:
             {
                 if(process_root)
                 {
-                    string_map      attrs;
-                    GumboAttribute* attr = nullptr;
-                    for(unsigned int i = 0; i < node->v.element.attributes.length; i++)
-                    {
-                        attr              = static_cast<GumboAttribute*>(node->v.element.attributes.data[i]);
-                        attrs[attr->name] = attr->value;
-                    }
-
-                    element::ptr ret;
-                    const char*  tag = gumbo_normalized_tagname(node->v.element.tag);
-                    if(tag[0])
+                    GumboTag    tag      = node->v.element.tag;
+                    const char* tag_name = gumbo_normalized_tagname(tag);
+                    std::string original_name;
+                    if(!tag_name[0])
                     {
-                        ret = create_element(tag, attrs);
-                    } else
-                    {
-                        if(node->v.element.original_tag.data && node->v.element.original_tag.length)
+                        if(!node->v.element.original_tag.data || !node->v.element.original_tag.length)
                         {
-                            std::string str;
-                            gumbo_tag_from_original_text(&node->v.element.original_tag);
-                            str.append(node->v.element.original_tag.data, node->v.element.original_tag.length);
-                            ret = create_element(str.c_str(), attrs);
+                            break;
                         }
+                        gumbo_tag_from_original_text(&node->v.element.original_tag);
+                        original_name.assign(node->v.element.original_tag.data, node->v.element.original_tag.length);
+                        tag_name = original_name.c_str();
+                        tag      = GUMBO_TAG_UNKNOWN;
                     }
-                    if(!strcmp(tag, "script"))
+
+                    element::ptr ret = litehtml::create_element(shared_from_this(), tag, tag_name,
+                                                                node->v.element.attributes);
+
+                    if(tag == GUMBO_TAG_SCRIPT)
                     {
                         parseTextNode = false;
                     }
-                    if(ret)
+                    for(unsigned int i = 0; i < node->v.element.children.length; i++)
                     {
-                        elements_list child;
-                        for(unsigned int i = 0; i < node->v.element.children.length; i++)
-                        {
-                            child.clear();
-                            create_node(static_cast<GumboNode*>(node->v.element.children.data[i]), child, parseTextNode,
-                                        true);
-                            std::for_each(child.begin(), child.end(),
-                                          [&ret](element::ptr& el) { ret->appendChild(el); });
-                        }
-                        elements.push_back(ret);
+                        create_node(node->v.element.children.data[i], ret, elements, parseTextNode, true);
                     }
+                    add_node(ret);
                 } else
                 {
                     for(unsigned int i = 0; i < node->v.element.children.length; i++)
                     {
-                        create_node(static_cast<GumboNode*>(node->v.element.children.data[i]), elements, parseTextNode,
-                                    true);
+                        create_node(node->v.element.children.data[i], parent, elements, parseTextNode, true);
                     }
                 }
             }
@@ -372,40 +512,41 @@ namespace litehtml
             {
                 if(!parseTextNode)
                 {
-                    elements.push_back(std::make_shared<el_text>(node->v.text.text, shared_from_this()));
+                    add_node(make_node<el_text>(m_arena, node->v.text.text, shared_from_this()));
                 } else
                 {
                     m_container->split_text(
                         node->v.text.text,
-                        [this, &elements](const char* text) {
-                            elements.push_back(std::make_shared<el_text>(text, shared_from_this()));
+                        [this, &add_node](const char* text) {
+                            add_node(make_node<el_text>(m_arena, text, shared_from_this()));
                         },
-                        [this, &elements](const char* text) {
-                            elements.push_back(std::make_shared<el_space>(text, shared_from_this()));
+                        [this, &add_node](const char* text) {
+                            add_node(make_node<el_space>(m_arena, text, shared_from_this()));
                         });
                 }
             }
             break;
         case GUMBO_NODE_CDATA:
             {
-                element::ptr ret = std::make_shared<el_cdata>(shared_from_this());
+                element::ptr ret = make_node<el_cdata>(m_arena, shared_from_this());
                 ret->set_data(node->v.text.text);
-                elements.push_back(ret);
+                add_node(ret);
             }
             break;
         case GUMBO_NODE_COMMENT:
             {
-                element::ptr ret = std::make_shared<el_comment>(shared_from_this());
+                element::ptr ret = make_node<el_comment>(m_arena, shared_from_this());
                 ret->set_data(node->v.text.text);
-                elements.push_back(ret);
+                add_node(ret);
             }
             break;
         case GUMBO_NODE_WHITESPACE:
             {
-                std::string str = node->v.text.text;
-                for(size_t i = 0; i < str.length(); i++)
+                char str[2] = {0, 0};
+                for(const char* ch = node->v.text.text; *ch; ch++)
                 {
-                    elements.push_back(std::make_shared<el_space>(str.substr(i, 1).c_str(), shared_from_this()));
+                    str[0] = *ch;
+                    add_node(make_node<el_space>(m_arena, str, shared_from_this()));
                 }
             }
             break;
@@ -416,75 +557,271 @@ namespace litehtml
 
     element::ptr document::create_element(const char* tag_name, const string_map& attributes)
     {
-        element::ptr  newTag;
-        document::ptr this_doc = shared_from_this();
-        if(m_container)
+        return litehtml::create_element(shared_from_this(), tag_from_name(tag_name), tag_name, attributes);
+    }
+
+    namespace
+    {
+        // Snapshot format: magic and version bytes, the size of css_properties (see snapshot_writer), the document mode
+        // byte, then the root node if the document has one.
+        // Node: kind byte, then for elements: tag name (except ::before and ::after), attributes count, name/value
+        // pairs, the computed properties of the tags (see css_properties::write), children count, children; for the
+        // other kinds: text.
+        const char    snapshot_magic[4] = {'L', 'H', 'D', 'S'};
+        const uint8_t snapshot_version  = 2;
+        // The nesting depth is read from the data, deeper snapshots are rejected instead of overflowing the stack.
+        // Browsers limit the parsed tree to a few hundred levels, so the valid documents are not affected.
+        const int snapshot_max_depth = 1024;
+
+        enum snapshot_node_kind : uint8_t
         {
-            newTag = m_container->create_element(tag_name, attributes, this_doc);
-        }
-        if(!newTag)
+            snapshot_element,
+            snapshot_text,
+            snapshot_space,
+            snapshot_comment,
+            snapshot_cdata,
+            snapshot_before,
+            snapshot_after,
+        };
+
+        void write_node(snapshot_writer& out, const element::ptr& el)
         {
-            if(!strcmp(tag_name, "br"))
-            {
-                newTag = std::make_shared<el_break>(this_doc);
-            } else if(!strcmp(tag_name, "p"))
+            std::string text;
+            if(el->is_comment() || el->is_text() || dynamic_cast<const el_cdata*>(el.get()))
             {
-                newTag = std::make_shared<el_para>(this_doc);
-            } else if(!strcmp(tag_name, "img"))
+                if(el->is_comment())
+                {
+                    out.write_byte(snapshot_comment);
+                } else if(el->is_space())
+                {
+                    out.write_byte(snapshot_space);
+                } else if(el->is_text())
+                {
+                    out.write_byte(snapshot_text);
+                } else
+                {
+                    out.write_byte(snapshot_cdata);
+                }
+                el->get_text(text);
+                out.write(text);
+                return;
+            }
+
+            auto tag = dynamic_cast<const html_tag*>(el.get());
+            if(tag && el->tag() == __tag_before_)
             {
-                newTag = std::make_shared<el_image>(this_doc);
-            } else if(!strcmp(tag_name, "table"))
+                out.write_byte(snapshot_before);
+            } else if(tag && el->tag() == __tag_after_)
             {
-                newTag = std::make_shared<el_table>(this_doc);
-            } else if(!strcmp(tag_name, "td") || !strcmp(tag_name, "th"))
+                out.write_byte(snapshot_after);
+            } else
             {
-                newTag = std::make_shared<el_td>(this_doc);
-            } else if(!strcmp(tag_name, "link"))
+                out.write_byte(snapshot_element);
+                out.write(std::string(el->get_tagName()));
+            }
+            if(tag)
             {
-                newTag = std::make_shared<el_link>(this_doc);
-            } else if(!strcmp(tag_name, "title"))
+                out.write_size(tag->attrs().size());
+                for(const auto& attr : tag->attrs())
+                {
+                    out.write(attr.get_name());
+                    out.write(attr.value);
+                }
+                tag->css().write(out);
+                out.write_size(el->children().size());
+                for(const auto& child : el->children())
+                {
+                    write_node(out, child);
+                }
+            } else
             {
-                newTag = std::make_shared<el_title>(this_doc);
-            } else if(!strcmp(tag_name, "a"))
+                // <script> and <style> keep their text instead of the children
+                out.write_size(0);
+                if(auto style = dynamic_cast<const el_style*>(el.get()))
+                {
+                    style->get_style_text(text);
+                } else
+                {
+                    el->get_text(text);
+                }
+                if(text.empty())
+                {
+                    out.write_size(0);
+                } else
+                {
+                    out.write_size(1);
+                    out.write_byte(snapshot_text);
+                    out.write(text);
+                }
+            }
+        }
+
+        element::ptr read_node(snapshot_reader& reader, const document::ptr& doc, int depth)
+        {
+            uint8_t kind = 0;
+            if(depth > snapshot_max_depth || !reader.read_byte(kind))
             {
-                newTag = std::make_shared<el_anchor>(this_doc);
-            } else if(!strcmp(tag_name, "tr"))
+                return nullptr;
+            }
+
+            std::string text;
+            if(kind != snapshot_element && kind != snapshot_before && kind != snapshot_after)
             {
-                newTag = std::make_shared<el_tr>(this_doc);
-            } else if(!strcmp(tag_name, "style"))
+                if(!reader.read(text))
+                {
+                    return nullptr;
+                }
+                switch(kind)
+                {
+                case snapshot_text:
+                    return make_node<el_text>(doc->arena(), text.c_str(), doc);
+                case snapshot_space:
+                    return make_node<el_space>(doc->arena(), text.c_str(), doc);
+                case snapshot_comment:
+                case snapshot_cdata:
+                    {
+                        element::ptr ret;
+                        if(kind == snapshot_comment)
+                        {
+                            ret = make_node<el_comment>(doc->arena(), doc);
+                        } else
+                        {
+                            ret = make_node<el_cdata>(doc->arena(), doc);
+                        }
+                        ret->set_data(text.c_str());
+                        return ret;
+                    }
+                default:
+                    return nullptr;
+                }
+            }
+
+            size_t         count = 0;
+            attribute_list attrs;
+            if((kind == snapshot_element && !reader.read(text)) || !reader.read_size(count))
             {
-                newTag = std::make_shared<el_style>(this_doc);
-            } else if(!strcmp(tag_name, "base"))
+                return nullptr;
+            }
+            for(size_t i = 0; i < count; i++)
             {
-                newTag = std::make_shared<el_base>(this_doc);
-            } else if(!strcmp(tag_name, "body"))
+                std::string name, value;
+                if(!reader.read(name) || !reader.read(value))
+                {
+                    return nullptr;
+                }
+                attrs.emplace_back(std::move(name), std::move(value));
+            }
+            element::ptr ret;
+            if(kind == snapshot_element)
             {
-                newTag = std::make_shared<el_body>(this_doc);
-            } else if(!strcmp(tag_name, "div"))
+                ret = create_element(doc, tag_from_name(text.c_str()), text.c_str(), attrs);
+            } else
             {
-                newTag = std::make_shared<el_div>(this_doc);
-            } else if(!strcmp(tag_name, "script"))
+                if(kind == snapshot_before)
+                {
+                    ret = make_node<el_before>(doc->arena(), doc);
+                } else
+                {
+                    ret = make_node<el_after>(doc->arena(), doc);
+                }
+                for(const auto& attr : attrs)
+                {
+                    ret->set_attr(attr.first.c_str(), attr.second.c_str());
+                }
+            }
+            if(!ret || (dynamic_cast<html_tag*>(ret.get()) && !ret->css_w().read(reader, doc)) ||
+               !reader.read_size(count))
             {
-                newTag = std::make_shared<el_script>(this_doc);
-            } else if(!strcmp(tag_name, "font"))
+                return nullptr;
+            }
+            for(size_t i = 0; i < count; i++)
             {
-                newTag = std::make_shared<el_font>(this_doc);
-            } else
+                element::ptr child = read_node(reader, doc, depth + 1);
+                if(!child)
+                {
+                    return nullptr;
+                }
+                ret->appendChild(child);
+            }
+            return ret;
+        }
+
+        // In the order of parse_attributes(): the parents before the children
+        void restore_tree(const element::ptr& el)
+        {
+            el->restore_state();
+            for(const auto& child : el->children())
             {
-                newTag = std::make_shared<html_tag>(this_doc);
+                restore_tree(child);
             }
         }
+    } // namespace
+
+    void document::serialize(std::string& out) const
+    {
+        snapshot_writer writer(out);
+        out.append(snapshot_magic, sizeof(snapshot_magic));
+        writer.write_byte(snapshot_version);
+        writer.write_size(sizeof(css_properties));
+        writer.write_byte(m_mode);
+        writer.write_size(m_root ? 1 : 0);
+        if(m_root)
+        {
+            write_node(writer, m_root);
+        }
+    }
 
-        if(newTag)
+    document::ptr document::deserialize(const char* data, size_t size, document_container* container)
+    {
+        if(size < sizeof(snapshot_magic) || memcmp(data, snapshot_magic, sizeof(snapshot_magic)) != 0)
         {
-            newTag->set_tagName(tag_name);
-            for(const auto& attribute : attributes)
+            return nullptr;
+        }
+        snapshot_reader reader(data + sizeof(snapshot_magic), size - sizeof(snapshot_magic));
+
+        uint8_t version  = 0;
+        size_t  css_size = 0;
+        uint8_t mode     = 0;
+        size_t  has_root = 0;
+        if(!reader.read_byte(version) || version != snapshot_version || !reader.read_size(css_size) ||
+           css_size != sizeof(css_properties) || !reader.read_byte(mode) || mode > limited_quirks_mode ||
+           !reader.read_size(has_root))
+        {
+            return nullptr;
+        }
+
+        document::ptr doc = std::make_shared<document>(container);
+        doc->m_mode       = static_cast<document_mode>(mode);
+        element::ptr root;
+        if(has_root)
+        {
+            root = read_node(reader, doc, 1);
+            if(!root)
             {
-                newTag->set_attr(attribute.first.c_str(), attribute.second.c_str());
+                return nullptr;
             }
         }
+        doc->finalize_from_snapshot(root);
+        return doc;
+    }
 
-        return newTag;
+    void document::finalize_from_snapshot(const element::ptr& root)
+    {
+        m_finalized = true;
+        m_root      = root;
+
+        // The elements have the computed properties, the stylesheets are neither parsed nor applied
+        if(m_root)
+        {
+            restore_tree(m_root);
+
+            m_root_render = m_root->create_render_item(nullptr);
+            fix_tables_layout();
+            if(m_root_render)
+            {
+                m_root_render = m_root_render->init();
+            }
+        }
     }
 
     uint_ptr document::add_font(const font_description& descr, font_metrics* fm)
@@ -559,6 +896,7 @@ namespace litehtml
                 m_size.height = 0;
                 m_root_render->calc_document_size(m_size);
             }
+            update_layers();
         }
         return ret;
     }
@@ -572,6 +910,121 @@ namespace litehtml
         }
     }
 
+    void document::enable_layers(bool enable)
+    {
+        if(m_layers_enabled != enable)
+        {
+            m_layers_enabled = enable;
+            update_layers();
+        }
+    }
+
+    // Layers are searched after the render, because the scroll views are created in calc_document_size()
+    void document::update_layers()
+    {
+        std::vector<std::shared_ptr<render_item>> layers;
+        if(m_root_render)
+        {
+            if(m_layers_enabled)
+            {
+                m_root_render->collect_layers(layers);
+
+                // The scroll layers are composited over the whole document layer, so the positioned elements drawn
+                // over the scroll box would be hidden. Such scroll boxes are drawn with the document.
+                layers.erase(std::remove_if(layers.begin(), layers.end(),
+                                            [this](const std::shared_ptr<render_item>& ri) {
+                                                if(ri->get_layer_type() != layer_type_scroll)
+                                                {
+                                                    return false;
+                                                }
+                                                bool layer_found = false;
+                                                if(!m_root_render->is_overlapped_by_positioned(
+                                                       ri.get(), ri->get_placement(), layer_found))
+                                                {
+                                                    return false;
+                                                }
+                                                ri->reset_layer();
+                                                return true;
+                                            }),
+                             layers.end());
+            } else if(!m_layers.empty())
+            {
+                // Nothing starts a layer inside a fixed layer, so this just resets the layer marks
+                m_root_render->collect_layers(layers, layer_type_fixed);
+                layers.clear();
+            }
+        }
+        m_layers = std::move(layers);
+    }
+
+    void document::get_layers(layer_info::vector& layers) const
+    {
+        layers.clear();
+
+        layer_info doc_layer;
+        doc_layer.type         = layer_type_document;
+        doc_layer.box          = position(0_px, 0_px, m_size.width, m_size.height);
+        doc_layer.content_size = m_size;
+        layers.push_back(doc_layer);
+
+        for(const auto& ri : m_layers)
+        {
+            layer_info info;
+            ri->get_layer_info(info);
+            layers.push_back(info);
+        }
+        // Fixed layers are composited on top of the document in the z-index order
+        std::stable_sort(layers.begin() + 1, layers.end(), [](const layer_info& left, const layer_info& right) {
+            if(left.type != right.type)
+            {
+                return left.type == layer_type_scroll;
+            }
+            return left.z_index < right.z_index;
+        });
+    }
+
+    void document::draw_layer(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip, uint_ptr layer_id)
+    {
+        if(!m_root || !m_root_render)
+        {
+            return;
+        }
+
+        std::shared_ptr<render_item> layer;
+        if(layer_id != 0)
+        {
+            for(const auto& ri : m_layers)
+            {
+                if(reinterpret_cast<uint_ptr>(ri.get()) == layer_id) // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                {
+                    layer = ri;
+                    break;
+                }
+            }
+            if(!layer)
+            {
+                return;
+            }
+        }
+
+        m_layered_draw = true;
+        m_draw_layer   = layer.get();
+        if(layer)
+        {
+            layer->draw_layer(hdc, x, y, clip);
+        } else
+        {
+            draw(hdc, x, y, clip);
+        }
+        m_layered_draw = false;
+        m_draw_layer   = nullptr;
+    }
+
+    bool document::is_layer_hidden(const render_item* ri) const
+    {
+        return m_layered_draw && ri != m_draw_layer && ri->get_layer_type() != layer_type_none;
+    }
+
     pixel_t document::to_pixels(const css_length& val, const font_metrics& metrics, pixel_t size) const
     {
         if(val.is_predefined())
@@ -655,6 +1108,50 @@ namespace litehtml
         return m_size.height;
     }
 
+    // Appends the exact description of the tokens, the equal keys are made of equal tokens only
+    static void append_tokens_key(std::string& key, const css_token_vector& tokens)
+    {
+        for(const auto& tok : tokens)
+        {
+            key.append(reinterpret_cast<const char*>(&tok.type), sizeof(tok.type));
+            switch(tok.type)
+            {
+            case HASH:
+                key += static_cast<char>(tok.hash_type);
+                break;
+            case NUMBER:
+            case PERCENTAGE:
+            case DIMENSION:
+                key.append(reinterpret_cast<const char*>(&tok.n.number), sizeof(tok.n.number));
+                key += static_cast<char>(tok.n.number_type);
+                break;
+            default:
+                break;
+            }
+            key += std::to_string(tok.str().size());
+            key += ':';
+            key += tok.str();
+            key += std::to_string(tok.repr.size());
+            key += ':';
+            key += tok.repr;
+            key += '(';
+            append_tokens_key(key, tok.value);
+            key += ')';
+        }
+    }
+
+    const style& document::parse_substituted_property(string_id name, const css_token_vector& value, bool important)
+    {
+        std::string key = std::to_string(static_cast<int>(name)) + (important ? "!" : ":");
+        append_tokens_key(key, value);
+        auto result = m_substituted_properties.try_emplace(std::move(key));
+        if(result.second)
+        {
+            result.first->second.add_property(name, value, "", important, m_container);
+        }
+        return result.first->second;
+    }
+
     void document::add_stylesheet(const char* str, const char* baseurl, const char* media)
     {
         if(str && str[0])
@@ -879,11 +1376,31 @@ namespace litehtml
 
     bool document::media_changed()
     {
-        container()->get_media_features(m_media);
-        if(update_media_lists(m_media))
+        media_features features;
+        container()->get_media_features(features);
+        if(!m_media_breakpoints_valid)
         {
-            m_root->refresh_styles();
-            m_root->compute_styles();
+            m_media_breakpoints.clear();
+            for(const auto& media_list : m_media_lists)
+            {
+                media_list->collect_breakpoints(m_media_breakpoints);
+            }
+            m_media_breakpoints.sort();
+            m_media_breakpoints_valid = true;
+        }
+        // Resizing without crossing a breakpoint can't change the results of the media queries
+        bool same_results = m_media_breakpoints.same_results(m_media, features);
+        m_media           = features;
+        if(same_results)
+        {
+            return false;
+        }
+
+        media_query_list_list::vector changed;
+        if(update_media_lists(m_media, &changed))
+        {
+            // Only the elements using the selectors from the changed media lists are restyled
+            m_root->refresh_media_styles(changed);
             // The set of rendered elements can change across a media breakpoint
             // (e.g. display:none <-> block on responsive nav/hero blocks). The render
             // tree is built once in createFromString() from the computed display values,
@@ -921,7 +1438,7 @@ namespace litehtml
     }
 
     // Apply media features (determine which selectors are active).
-    bool document::update_media_lists(const media_features& features)
+    bool document::update_media_lists(const media_features& features, media_query_list_list::vector* changed)
     {
         bool update_styles = false;
         for(auto& media_list : m_media_lists)
@@ -929,6 +1446,10 @@ namespace litehtml
             if(media_list->apply_media_features(features))
             {
                 update_styles = true;
+                if(changed)
+                {
+                    changed->push_back(media_list);
+                }
             }
         }
         return update_styles;
@@ -939,6 +1460,7 @@ namespace litehtml
         if(list && !contains(m_media_lists, list))
         {
             m_media_lists.push_back(list);
+            m_media_breakpoints_valid = false;
         }
     }
 
@@ -987,23 +1509,23 @@ namespace litehtml
     void document::fix_table_children(const std::shared_ptr<render_item>& el_ptr, style_display disp,
                                       const char* disp_str)
     {
-        std::list<std::shared_ptr<render_item>> tmp;
-        auto                                    first_iter = el_ptr->children().begin();
-        auto                                    cur_iter   = el_ptr->children().begin();
+        std::vector<std::shared_ptr<render_item>> tmp;
+        auto                                      first_iter = el_ptr->children().begin();
+        auto                                      cur_iter   = el_ptr->children().begin();
 
         auto flush_elements = [&]() {
-            element::ptr annon_tag = std::make_shared<html_tag>(el_ptr->src_el(), std::string("display:") + disp_str);
+            element::ptr annon_tag = make_node<html_tag>(m_arena, el_ptr->src_el(), std::string("display:") + disp_str);
             std::shared_ptr<render_item> annon_ri;
             if(annon_tag->css().get_display() == display_table_cell)
             {
                 annon_tag->set_tagName("table_cell");
-                annon_ri = std::make_shared<render_item_block>(annon_tag);
+                annon_ri = make_node<render_item_block>(m_arena, annon_tag);
             } else if(annon_tag->css().get_display() == display_table_row)
             {
-                annon_ri = std::make_shared<render_item_table_row>(annon_tag);
+                annon_ri = make_node<render_item_table_row>(m_arena, annon_tag);
             } else
             {
-                annon_ri = std::make_shared<render_item_table_part>(annon_tag);
+                annon_ri = make_node<render_item_table_part>(m_arena, annon_tag);
             }
             for(const auto& el : tmp)
             {
@@ -1107,18 +1629,18 @@ namespace litehtml
 
                 // extract elements with the same display and wrap them with anonymous object
                 element::ptr annon_tag =
-                    std::make_shared<html_tag>(parent->src_el(), std::string("display:") + disp_str);
+                    make_node<html_tag>(m_arena, parent->src_el(), std::string("display:") + disp_str);
                 std::shared_ptr<render_item> annon_ri;
                 if(annon_tag->css().get_display() == display_table ||
                    annon_tag->css().get_display() == display_inline_table)
                 {
-                    annon_ri = std::make_shared<render_item_table>(annon_tag);
+                    annon_ri = make_node<render_item_table>(m_arena, annon_tag);
                 } else if(annon_tag->css().get_display() == display_table_row)
                 {
-                    annon_ri = std::make_shared<render_item_table_row>(annon_tag);
+                    annon_ri = make_node<render_item_table_row>(m_arena, annon_tag);
                 } else
                 {
-                    annon_ri = std::make_shared<render_item_table_part>(annon_tag);
+                    annon_ri = make_node<render_item_table_part>(m_arena, annon_tag);
                 }
                 std::for_each(first, std::next(last, 1),
                               [&annon_ri](std::shared_ptr<render_item>& el) { annon_ri->add_child(el); });
@@ -1130,6 +1652,29 @@ namespace litehtml
         }
     }
 
+    memory_usage_info document::memory_usage() const
+    {
+        memory_usage_info usage;
+        usage.dom += sizeof(document);
+        if(m_root)
+        {
+            m_root->get_memory_usage(usage);
+        }
+        if(m_root_render)
+        {
+            m_root_render->get_memory_usage(usage);
+        }
+        for(const css* sheet : {&m_styles, &m_master_css, &m_user_css})
+        {
+            usage.styles += sheet->selectors().size() * (sizeof(css_selector::ptr) + sizeof(css_selector));
+        }
+        for(const auto& css : m_css)
+        {
+            usage.styles += sizeof(css_text) + css.text.capacity() + css.baseurl.capacity() + css.media.capacity();
+        }
+        return usage;
+    }
+
     void document::append_children_from_string(element& parent, const char* str, bool replace_existing)
     {
         // parent must belong to this document
@@ -1148,7 +1693,7 @@ namespace litehtml
         // Create litehtml::elements.
         elements_list child_elements;
         // Create elements excluding the root node
-        create_node(output->root, child_elements, true, false);
+        create_node(output->root, nullptr, child_elements, true, false);
 
         // Destroy GumboOutput
         gumbo_destroy_output(&kGumboDefaultOptions, output);
@@ -0,0 +1,80 @@
+#include "html.h"
+#include "document_builder.h"
+
+namespace litehtml
+{
+    document_builder::document_builder(document_container* container, const std::string& master_styles,
+                                       const std::string& user_styles, encoding enc) :
+        m_container(container),
+        m_master_styles(master_styles),
+        m_user_styles(user_styles),
+        m_source("", enc)
+    {
+        if(enc != encoding::null)
+        {
+            m_encoding         = enc;
+            m_confidence       = confidence::certain;
+            m_encoding_sniffed = true;
+        }
+    }
+
+    void document_builder::append(const char* data, size_t len)
+    {
+        m_source.append(data, len);
+        if(!m_encoding_sniffed && m_source.size() >= encoding_sniffing_size)
+        {
+            sniff_encoding(false);
+        }
+    }
+
+    void document_builder::sniff_encoding(bool complete)
+    {
+        // The same bytes createFromString would sniff in the complete source
+        estring str(m_source.substr(0, encoding_sniffing_size), encoding::null, confidence::certain);
+        encoding_sniffing_algorithm(str);
+        m_encoding   = str.encoding;
+        m_confidence = str.confidence;
+        // The <meta> of the short source may be not received yet
+        m_encoding_sniffed = complete || m_source.size() >= encoding_sniffing_size;
+    }
+
+    document::ptr document_builder::create_partial_document()
+    {
+        if(!m_encoding_sniffed)
+        {
+            sniff_encoding(false);
+        }
+
+        size_t size = m_source.size();
+        if(m_encoding == encoding::utf_16be || m_encoding == encoding::utf_16le)
+        {
+            // Bytes of '>' can't be searched in UTF-16, cut the incomplete code unit only
+            size &= ~static_cast<size_t>(1);
+        } else
+        {
+            // Cutting after '>' drops the incomplete tag and the incomplete multibyte character
+            auto pos = m_source.rfind('>');
+            size     = pos == std::string::npos ? 0 : pos + 1;
+        }
+        if(size == 0 || size <= m_partial_size)
+        {
+            return nullptr;
+        }
+        m_partial_size = size;
+
+        // A tentative encoding is still changed by a <meta> the parser finds, the same way as in the final document
+        estring str(m_source.substr(0, size), m_encoding, m_confidence);
+        return document::createFromString(str, m_container, m_master_styles, m_user_styles);
+    }
+
+    document::ptr document_builder::finish()
+    {
+        if(!m_encoding_sniffed)
+        {
+            sniff_encoding(true);
+        }
+        m_partial_size = m_source.size();
+        estring str(m_source, m_encoding, m_confidence);
+        return document::createFromString(str, m_container, m_master_styles, m_user_styles);
+    }
+} // namespace litehtml
@@ -9,7 +9,7 @@ litehtml::el_anchor::el_anchor(const std::shared_ptr<litehtml::document>& doc) :
 
 void litehtml::el_anchor::on_click()
 {
-    const char* href = get_attr("href");
+    const char* href = get_attr(_href_);
 
     if(href)
     {
@@ -19,7 +19,7 @@ void litehtml::el_anchor::on_click()
 
 void litehtml::el_anchor::apply_stylesheet(const litehtml::css& stylesheet)
 {
-    if(get_attr("href"))
+    if(get_attr(_href_))
     {
         m_pseudo_classes.push_back(_link_);
     }
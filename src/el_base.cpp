@@ -9,5 +9,10 @@ litehtml::el_base::el_base(const std::shared_ptr<document>& doc) :
 
 void litehtml::el_base::parse_attributes()
 {
-    get_document()->container()->set_base_url(get_attr("href"));
+    get_document()->container()->set_base_url(get_attr(_href_));
+}
+
+void litehtml::el_base::restore_state()
+{
+    parse_attributes();
 }
@@ -18,3 +18,10 @@ void litehtml::el_cdata::set_data(const char* data)
         m_text += data;
     }
 }
+
+void litehtml::el_cdata::get_memory_usage(memory_usage_info& usage) const
+{
+    element::get_memory_usage(usage);
+    usage.dom  += sizeof(el_cdata) - sizeof(element) - sizeof(std::string);
+    usage.text += sizeof(std::string) + m_text.capacity();
+}
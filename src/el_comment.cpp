@@ -23,3 +23,10 @@ void litehtml::el_comment::set_data(const char* data)
         m_text += data;
     }
 }
+
+void litehtml::el_comment::get_memory_usage(memory_usage_info& usage) const
+{
+    element::get_memory_usage(usage);
+    usage.dom  += sizeof(el_comment) - sizeof(element) - sizeof(std::string);
+    usage.text += sizeof(std::string) + m_text.capacity();
+}
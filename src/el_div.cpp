@@ -8,7 +8,7 @@ litehtml::el_div::el_div(const document::ptr& doc) :
 
 void litehtml::el_div::parse_attributes()
 {
-    const char* str = get_attr("align");
+    const char* str = get_attr(_align_);
     if(str)
     {
         m_style.add_property(_text_align_, str);
@@ -8,19 +8,19 @@ litehtml::el_font::el_font(const std::shared_ptr<document>& doc) :
 
 void litehtml::el_font::parse_attributes()
 {
-    const char* str = get_attr("color");
+    const char* str = get_attr(_color_);
     if(str)
     {
         m_style.add_property(_color_, str, "", false, get_document()->container());
     }
 
-    str = get_attr("face");
+    str = get_attr(_face_);
     if(str)
     {
         m_style.add_property(_font_family_, str);
     }
 
-    str = get_attr("size");
+    str = get_attr(_size_);
     if(str)
     {
         int sz = atoi(str);
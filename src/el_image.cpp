@@ -20,16 +20,16 @@ bool litehtml::el_image::is_replaced() const
 
 void litehtml::el_image::parse_attributes()
 {
-    m_src = get_attr("src", "");
+    m_src = get_attr(_src_, "");
 
     // https://html.spec.whatwg.org/multipage/rendering.html#attributes-for-embedded-content-and-images:the-img-element-5
-    const char* str = get_attr("width");
+    const char* str = get_attr(_width_);
     if(str)
     {
         map_to_dimension_property(_width_, str);
     }
 
-    str = get_attr("height");
+    str = get_attr(_height_);
     if(str)
     {
         map_to_dimension_property(_height_, str);
@@ -67,7 +67,17 @@ void litehtml::el_image::draw(uint_ptr hdc, pixel_t x, pixel_t y, const position
 void litehtml::el_image::compute_styles(bool recursive)
 {
     html_tag::compute_styles(recursive);
+    load_image();
+}
 
+void litehtml::el_image::restore_state()
+{
+    parse_attributes();
+    load_image();
+}
+
+void litehtml::el_image::load_image()
+{
     if(!m_src.empty())
     {
         if(!css().get_height().is_predefined() && !css().get_width().is_predefined())
@@ -88,7 +98,7 @@ std::string litehtml::el_image::dump_get_name()
 std::shared_ptr<litehtml::render_item> litehtml::el_image::create_render_item(
     const std::shared_ptr<render_item>& parent_ri)
 {
-    auto ret = std::make_shared<render_item_image>(shared_from_this());
+    auto ret = make_node<render_item_image>(get_arena(), shared_from_this());
     ret->parent(parent_ri);
     return ret;
 }
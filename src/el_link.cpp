@@ -14,11 +14,11 @@ void litehtml::el_link::parse_attributes()
 
     document::ptr doc = get_document();
 
-    const char* rel = get_attr("rel");
+    const char* rel = get_attr(_rel_);
     if(rel && !strcmp(rel, "stylesheet"))
     {
-        const char* media = get_attr("media");
-        const char* href  = get_attr("href");
+        const char* media = get_attr(_media_);
+        const char* href  = get_attr(_href_);
         if(href && href[0])
         {
             std::string css_text;
@@ -37,3 +37,14 @@ void litehtml::el_link::parse_attributes()
         doc->container()->link(doc, shared_from_this());
     }
 }
+
+void litehtml::el_link::restore_state()
+{
+    // The imported stylesheets are applied to the properties in the snapshot already
+    const char* rel = get_attr(_rel_);
+    if(!rel || strcmp(rel, "stylesheet"))
+    {
+        document::ptr doc = get_document();
+        doc->container()->link(doc, shared_from_this());
+    }
+}
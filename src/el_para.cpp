@@ -8,7 +8,7 @@ litehtml::el_para::el_para(const std::shared_ptr<document>& doc) :
 
 void litehtml::el_para::parse_attributes()
 {
-    const char* str = get_attr("align");
+    const char* str = get_attr(_align_);
     if(str)
     {
         m_style.add_property(_text_align_, str);
@@ -26,3 +26,10 @@ const char* litehtml::el_script::get_tagName() const
 {
     return "script";
 }
+
+void litehtml::el_script::get_memory_usage(memory_usage_info& usage) const
+{
+    element::get_memory_usage(usage);
+    usage.dom  += sizeof(el_script) - sizeof(element) - sizeof(std::string);
+    usage.text += sizeof(std::string) + m_text.capacity();
+}
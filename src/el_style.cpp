@@ -9,12 +9,8 @@ litehtml::el_style::el_style(const std::shared_ptr<document>& doc) :
 void litehtml::el_style::parse_attributes()
 {
     std::string text;
-
-    for(auto& el : m_children)
-    {
-        el->get_text(text);
-    }
-    get_document()->add_stylesheet(text.c_str(), nullptr, get_attr("media"));
+    get_style_text(text);
+    get_document()->add_stylesheet(text.c_str(), nullptr, get_attr(_media_));
 }
 
 bool litehtml::el_style::appendChild(const ptr& el)
@@ -41,3 +37,11 @@ const char* litehtml::el_style::get_tagName() const
 {
     return "style";
 }
+
+void litehtml::el_style::get_style_text(std::string& text) const
+{
+    for(const auto& el : m_children)
+    {
+        el->get_text(text);
+    }
+}
@@ -25,35 +25,35 @@ namespace litehtml
     void el_table::parse_attributes()
     {
         // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-table-width
-        const char* str = get_attr("width");
+        const char* str = get_attr(_width_);
         if(str)
         {
             map_to_dimension_property_ignoring_zero(_width_, str);
         }
 
         // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-table-height
-        str = get_attr("height");
+        str = get_attr(_height_);
         if(str)
         {
             map_to_dimension_property(_height_, str);
         }
 
         // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-table-cellspacing
-        str = get_attr("cellspacing");
+        str = get_attr(_cellspacing_);
         if(str)
         {
             map_to_pixel_length_property(_border_spacing_, str);
         }
 
         // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-table-border
-        str = get_attr("border");
+        str = get_attr(_border_);
         if(str)
         {
             map_to_pixel_length_property_with_default_value(_border_width_, str, 1);
         }
 
         // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-background
-        str = get_attr("bgcolor");
+        str = get_attr(_bgcolor_);
         if(str)
         {
             m_style.add_property(_background_color_, str, "", false, get_document()->container());
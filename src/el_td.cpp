@@ -12,21 +12,21 @@ namespace litehtml
     void el_td::parse_attributes()
     {
         // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-tdth-width
-        const char* str = get_attr("width");
+        const char* str = get_attr(_width_);
         if(str)
         {
             map_to_dimension_property_ignoring_zero(_width_, str);
         }
 
         // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-tdth-height
-        str = get_attr("height");
+        str = get_attr(_height_);
         if(str)
         {
             map_to_dimension_property_ignoring_zero(_height_, str);
         }
 
         // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-background
-        str = get_attr("background");
+        str = get_attr(_background_);
         if(str)
         {
             std::string url  = "url('";
@@ -35,19 +35,19 @@ namespace litehtml
             m_style.add_property(_background_image_, url);
         }
 
-        str = get_attr("bgcolor");
+        str = get_attr(_bgcolor_);
         if(str)
         {
             m_style.add_property(_background_color_, str, "", false, get_document()->container());
         }
 
-        str = get_attr("align");
+        str = get_attr(_align_);
         if(str)
         {
             m_style.add_property(_text_align_, str);
         }
 
-        str = get_attr("valign");
+        str = get_attr(_valign_);
         if(str)
         {
             m_style.add_property(_vertical_align_, str);
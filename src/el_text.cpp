@@ -27,12 +27,10 @@ void litehtml::el_text::get_text(std::string& text) const
 
 void litehtml::el_text::compute_styles(bool /*recursive*/)
 {
-    element::ptr el_parent = parent();
+    element* el_parent = parent_ptr();
     if(el_parent)
     {
-        css_w().line_height_w() = el_parent->css().line_height();
-        css_w().set_font(el_parent->css().get_font());
-        css_w().set_font_metrics(el_parent->css().get_font_metrics());
+        css_w().inherit_font(el_parent->css());
         css_w().set_white_space(el_parent->css().get_white_space());
         css_w().set_text_transform(el_parent->css().get_text_transform());
     }
@@ -43,13 +41,13 @@ void litehtml::el_text::compute_styles(bool /*recursive*/)
     {
         m_transformed_text = m_text;
         m_use_transformed  = true;
-        get_document()->container()->transform_text(m_transformed_text, m_css.get_text_transform());
+        document_ptr()->container()->transform_text(m_transformed_text, m_css.get_text_transform());
     } else
     {
         m_use_transformed = false;
     }
 
-    element::ptr p = parent();
+    element* p = el_parent;
     while(p && p->css().get_display() == display_inline)
     {
         if(p->css().get_position() == element_position_relative)
@@ -58,7 +56,7 @@ void litehtml::el_text::compute_styles(bool /*recursive*/)
             css_w().set_position(element_position_relative);
             break;
         }
-        p = p->parent();
+        p = p->parent_ptr();
     }
     if(p)
     {
@@ -97,7 +95,7 @@ void litehtml::el_text::compute_styles(bool /*recursive*/)
     } else
     {
         m_size.height = fm.height;
-        m_size.width  = get_document()->container()->text_width(
+        m_size.width  = document_ptr()->container()->text_width(
             m_use_transformed ? m_transformed_text.c_str() : m_text.c_str(), font);
     }
     m_draw_spaces = fm.draw_spaces;
@@ -118,10 +116,10 @@ void litehtml::el_text::draw(uint_ptr hdc, pixel_t x, pixel_t y, const position*
 
     if(pos.does_intersect(clip))
     {
-        element::ptr el_parent = parent();
+        element* el_parent = parent_ptr();
         if(el_parent)
         {
-            document::ptr doc = get_document();
+            document* doc = document_ptr();
 
             uint_ptr font = el_parent->css().get_font();
             if(font)
@@ -134,6 +132,70 @@ void litehtml::el_text::draw(uint_ptr hdc, pixel_t x, pixel_t y, const position*
     }
 }
 
+bool litehtml::el_text::add_to_run(text_run& run, pixel_t x, pixel_t y, const std::shared_ptr<render_item>& ri) const
+{
+    element* el_parent = parent_ptr();
+    uint_ptr font      = el_parent ? el_parent->css().get_font() : 0;
+    if(!font)
+    {
+        // Nothing to draw
+        return true;
+    }
+    // Hidden spaces are not drawn, but can be inside the run
+    if(is_white_space() && !m_draw_spaces && run.empty())
+    {
+        return true;
+    }
+
+    position pos  = ri->pos();
+    pos.x        += x;
+    pos.y        += y;
+
+    // Justified text is wider than the measured text, so the words must be placed separately
+    if(pos.width != m_size.width)
+    {
+        return false;
+    }
+
+    return run.add(m_use_transformed ? m_transformed_text : m_text, font, el_parent->css().get_color(), pos);
+}
+
+bool litehtml::text_run::add(const std::string& text, uint_ptr font, const web_color& color, const position& pos)
+{
+    if(m_font == 0)
+    {
+        m_font  = font;
+        m_color = color;
+        m_pos   = pos;
+        m_text  = text;
+        return true;
+    }
+    if(font != m_font || color != m_color || pos.y != m_pos.y || pos.height != m_pos.height ||
+       pos.x != m_pos.right())
+    {
+        return false;
+    }
+    m_text      += text;
+    m_pos.width  = pos.right() - m_pos.x;
+    return true;
+}
+
+void litehtml::text_run::flush(uint_ptr hdc, const position* clip, document_container* container)
+{
+    if(m_font == 0)
+    {
+        return;
+    }
+    position pos = m_pos;
+    pos.round();
+    if(pos.does_intersect(clip))
+    {
+        container->draw_text(hdc, m_text.c_str(), m_font, m_color, pos);
+    }
+    m_text.clear();
+    m_font = 0;
+}
+
 std::string litehtml::el_text::dump_get_name()
 {
     return "text: \"" + get_escaped_string(m_text) + "\"";
@@ -143,3 +205,10 @@ std::vector<std::tuple<std::string, std::string>> litehtml::el_text::dump_get_at
 {
     return {};
 }
+
+void litehtml::el_text::get_memory_usage(memory_usage_info& usage) const
+{
+    element::get_memory_usage(usage);
+    usage.dom  += sizeof(el_text) - sizeof(element) - sizeof(std::string) * 2;
+    usage.text += sizeof(std::string) * 2 + m_text.capacity() + m_transformed_text.capacity();
+}
@@ -13,3 +13,8 @@ void litehtml::el_title::parse_attributes()
     get_text(text);
     get_document()->container()->set_caption(text.c_str());
 }
+
+void litehtml::el_title::restore_state()
+{
+    parse_attributes();
+}
@@ -9,23 +9,23 @@ litehtml::el_tr::el_tr(const std::shared_ptr<document>& doc) :
 void litehtml::el_tr::parse_attributes()
 {
     // https://html.spec.whatwg.org/multipage/rendering.html#tables-2:attr-tr-height
-    const char* str = get_attr("height");
+    const char* str = get_attr(_height_);
     if(str)
     {
         map_to_dimension_property(_height_, str);
     }
 
-    str = get_attr("align");
+    str = get_attr(_align_);
     if(str)
     {
         m_style.add_property(_text_align_, str);
     }
-    str = get_attr("valign");
+    str = get_attr(_valign_);
     if(str)
     {
         m_style.add_property(_vertical_align_, str);
     }
-    str = get_attr("bgcolor");
+    str = get_attr(_bgcolor_);
     if(str)
     {
         m_style.add_property(_background_color_, str, "", false, get_document()->container());
@@ -19,10 +19,28 @@ namespace litehtml
     }
 
     element::element(const document::ptr& doc) :
-        m_doc(doc)
+        m_doc(doc),
+        m_doc_ptr(doc.get())
     {
     }
 
+    element::~element()
+    {
+        for(const auto& child : m_children)
+        {
+            if(child->m_parent_ptr == this)
+            {
+                child->m_parent_ptr = nullptr;
+            }
+        }
+    }
+
+    std::shared_ptr<node_arena> element::get_arena() const
+    {
+        auto doc = get_document();
+        return doc ? doc->arena() : nullptr;
+    }
+
     position element::get_placement() const
     {
         position pos;
@@ -68,12 +86,12 @@ namespace litehtml
 
     bool element::is_ancestor(const ptr& el) const
     {
-        element::ptr el_parent = parent();
-        while(el_parent && el_parent != el)
+        element* el_parent = parent_ptr();
+        while(el_parent && el_parent != el.get())
         {
-            el_parent = el_parent->parent();
+            el_parent = el_parent->parent_ptr();
         }
-        return static_cast<bool>(el_parent);
+        return el_parent != nullptr;
     }
 
     bool element::is_table_skip() const
@@ -91,6 +109,19 @@ namespace litehtml
         return m_css.dump_get_attrs();
     }
 
+    void element::get_memory_usage(memory_usage_info& usage) const
+    {
+        usage.dom += sizeof(element) - sizeof(css_properties);
+        usage.dom +=
+            m_children.capacity() * sizeof(element::ptr) + m_renders.capacity() * sizeof(std::weak_ptr<render_item>);
+        usage.styles += m_used_styles.capacity() * sizeof(used_selector);
+        m_css.get_memory_usage(usage);
+        for(const auto& el : m_children)
+        {
+            el->get_memory_usage(usage);
+        }
+    }
+
     void element::dump(dumper& cout)
     {
         cout.begin_node(dump_get_name());
@@ -127,27 +158,27 @@ namespace litehtml
            css().get_display() == display_table_footer_group || css().get_display() == display_table_header_group ||
            css().get_display() == display_table_row_group)
         {
-            ret = std::make_shared<render_item_table_part>(shared_from_this());
+            ret = make_node<render_item_table_part>(get_arena(), shared_from_this());
         } else if(css().get_display() == display_table_row)
         {
-            ret = std::make_shared<render_item_table_row>(shared_from_this());
+            ret = make_node<render_item_table_row>(get_arena(), shared_from_this());
         } else if(css().get_display() == display_block || css().get_display() == display_table_cell ||
                   css().get_display() == display_table_caption || css().get_display() == display_list_item ||
                   css().get_display() == display_inline_block)
         {
-            ret = std::make_shared<render_item_block>(shared_from_this());
+            ret = make_node<render_item_block>(get_arena(), shared_from_this());
         } else if(css().get_display() == display_table || css().get_display() == display_inline_table)
         {
-            ret = std::make_shared<render_item_table>(shared_from_this());
+            ret = make_node<render_item_table>(get_arena(), shared_from_this());
         } else if(css().get_display() == display_inline)
         {
-            ret = std::make_shared<render_item_inline>(shared_from_this());
+            ret = make_node<render_item_inline>(get_arena(), shared_from_this());
         } else if(css().get_display() == display_inline_text)
         {
-            ret = std::make_shared<render_text>(shared_from_this());
+            ret = make_node<render_text>(get_arena(), shared_from_this());
         } else if(css().get_display() == display_flex || css().get_display() == display_inline_flex)
         {
-            ret = std::make_shared<render_item_flex>(shared_from_this());
+            ret = make_node<render_item_flex>(get_arena(), shared_from_this());
         }
         if(ret)
         {
@@ -177,10 +208,10 @@ namespace litehtml
     {
         for(const auto& used_style : m_used_styles)
         {
-            if(used_style->m_selector->is_media_valid())
+            if(used_style.m_selector->is_media_valid())
             {
-                int res = select(*(used_style->m_selector), true);
-                if((res == select_no_match && used_style->m_used) || (res == select_match && !used_style->m_used))
+                int res = select(*(used_style.m_selector), true);
+                if((res == select_no_match && used_style.m_used) || (res == select_match && !used_style.m_used))
                 {
                     return true;
                 }
@@ -212,6 +243,7 @@ namespace litehtml
                     if(ri)
                     {
                         ri->get_rendering_boxes(redraw_box);
+                        ri->clear_background_cache();
                     }
                 }
             };
@@ -220,6 +252,20 @@ namespace litehtml
             {
                 process_boxes(el);
             }
+            // The root element can draw the background of the body
+            if(is_body())
+            {
+                if(auto el_parent = parent())
+                {
+                    for(const auto& weak_ri : el_parent->m_renders)
+                    {
+                        if(auto ri = weak_ri.lock())
+                        {
+                            ri->clear_background_cache();
+                        }
+                    }
+                }
+            }
 
             refresh_styles();
             compute_styles();
@@ -240,11 +286,11 @@ namespace litehtml
         element::ptr el;
         if(type == 0)
         {
-            el = std::make_shared<el_before>(get_document());
+            el = make_node<el_before>(get_arena(), get_document());
             m_children.insert(m_children.begin(), el);
         } else
         {
-            el = std::make_shared<el_after>(get_document());
+            el = make_node<el_after>(get_arena(), get_document());
             m_children.insert(m_children.end(), el);
         }
         el->parent(shared_from_this());
@@ -475,9 +521,11 @@ namespace litehtml
     void        element::set_attr(const char* /*name*/, const char* /*val*/) LITEHTML_EMPTY_FUNC;
     void        element::apply_stylesheet(const litehtml::css& /*stylesheet*/) LITEHTML_EMPTY_FUNC;
     void        element::refresh_styles() LITEHTML_EMPTY_FUNC;
+    void        element::refresh_media_styles(const media_query_list_list::vector& /*changed*/) LITEHTML_EMPTY_FUNC;
     void        element::on_click() LITEHTML_EMPTY_FUNC;
     void        element::compute_styles(bool /*recursive*/) LITEHTML_EMPTY_FUNC;
     const char* element::get_attr(const char* /*name*/, const char* def /*= 0*/) const LITEHTML_RETURN_FUNC(def);
+    const char* element::get_attr(string_id /*name*/, const char* def /*= 0*/) const LITEHTML_RETURN_FUNC(def);
     bool        element::is_white_space() const LITEHTML_RETURN_FUNC(false);
     bool        element::is_space() const LITEHTML_RETURN_FUNC(false);
     bool        element::is_comment() const LITEHTML_RETURN_FUNC(false);
@@ -507,4 +555,9 @@ namespace litehtml
     element::ptr element::find_ancestor(const css_selector& /*selector*/, bool /*apply_pseudo*/, bool* /*is_pseudo*/)
         LITEHTML_RETURN_FUNC(nullptr);
 
+    void element::restore_state()
+    {
+        compute_styles(false);
+    }
+
 } // namespace litehtml
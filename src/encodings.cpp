@@ -3,7 +3,12 @@
 #include "utf8_strings.h"
 #include "encodings.h"
 #include <cassert>
+#include <cstring>
 #include <utility>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LITEHTML_USE_SSE2
+#endif
 
 #define out
 #define inout
@@ -61,19 +66,124 @@ namespace litehtml
             result_codepoint
         };
 
-        result process_a_queue(std::string& input, std::string& output, error_mode mode);
+        result process_a_queue(std::string& input, int index, std::string& output, error_mode mode);
         result process_an_item(std::string& input, int& input_index, std::string& output, error_mode mode);
 
         // NOTE: input can be modified by GB18030, ISO-2022-JP and UTF-16 decoders (search for "input.insert")
         virtual result handler(inout std::string& input, inout int& index, out int ch[2]) = 0;
+
+        // Decodes as many bytes as possible without running the handler byte by byte. It must stop before any byte
+        // producing an error, so the errors are still reported by the handler according to the error mode.
+        virtual void bulk_decode(const std::string& /*input*/, inout int& /*index*/, std::string& /*output*/) {}
     };
 
+    // Returns the length of the ASCII prefix of the data
+    static size_t ascii_prefix_length(const char* data, size_t size)
+    {
+        size_t pos = 0;
+#ifdef LITEHTML_USE_SSE2
+        for(; pos + 16 <= size; pos += 16)
+        {
+            // The non-ASCII byte is located by the scalar loops below
+            if(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos))) != 0)
+            {
+                break;
+            }
+        }
+#endif
+        for(; pos + 8 <= size; pos += 8)
+        {
+            uint64_t chunk;
+            memcpy(&chunk, data + pos, 8);
+            if(chunk & 0x8080808080808080ull)
+            {
+                break;
+            }
+        }
+        while(pos < size && !(data[pos] & 0x80))
+        {
+            pos++;
+        }
+        return pos;
+    }
+
+    // Returns the length of the valid UTF-8 prefix of the data. Incomplete sequence at the end is not included.
+    // https://encoding.spec.whatwg.org/#utf-8-decoder accepts the same sequences as this function.
+    static size_t utf_8_valid_prefix_length(const char* data, size_t size)
+    {
+        size_t pos = 0;
+        while(true)
+        {
+            pos += ascii_prefix_length(data + pos, size - pos);
+            // Multibyte characters usually go in runs, so check them here without returning to the ASCII scan
+            while(pos < size)
+            {
+                auto b = static_cast<byte>(data[pos]);
+                if(b < 0x80)
+                {
+                    break;
+                }
+                int lower  = 0x80;
+                int upper  = 0xBF;
+                int length = 0;
+                if(b >= 0xC2 && b <= 0xDF)
+                {
+                    length = 2;
+                } else if(b >= 0xE0 && b <= 0xEF)
+                {
+                    length = 3;
+                    if(b == 0xE0)
+                    {
+                        lower = 0xA0;
+                    } else if(b == 0xED)
+                    {
+                        upper = 0x9F;
+                    }
+                } else if(b >= 0xF0 && b <= 0xF4)
+                {
+                    length = 4;
+                    if(b == 0xF0)
+                    {
+                        lower = 0x90;
+                    } else if(b == 0xF4)
+                    {
+                        upper = 0x8F;
+                    }
+                } else
+                {
+                    return pos;
+                }
+                if(size - pos < static_cast<size_t>(length))
+                {
+                    return pos;
+                }
+                auto b1 = static_cast<byte>(data[pos + 1]);
+                if(b1 < lower || b1 > upper)
+                {
+                    return pos;
+                }
+                for(int i = 2; i < length; i++)
+                {
+                    if((static_cast<byte>(data[pos + i]) & 0xC0) != 0x80)
+                    {
+                        return pos;
+                    }
+                }
+                pos += length;
+            }
+            if(pos >= size)
+            {
+                return size;
+            }
+        }
+    }
+
     // https://encoding.spec.whatwg.org/#concept-encoding-run
-    decoder::result decoder::process_a_queue(std::string& input, std::string& output, error_mode mode)
+    decoder::result decoder::process_a_queue(std::string& input, int index, std::string& output, error_mode mode)
     {
-        int index = 0;
         while(true)
         {
+            bulk_decode(input, index, output);
             // NOTE: we read byte from input in decoder handlers, not here (standard prescribes to do it here).
             auto result = process_an_item(input, index, output, mode);
             if(result != result_continue)
@@ -171,16 +281,25 @@ namespace litehtml
         encoding bom_encoding = bom_sniff(input);
 
         // 2.
+        int bom_len = 0;
         if(bom_encoding != encoding::null)
         {
             _encoding = bom_encoding;
-            int len   = (_encoding == encoding::utf_8 ? 3 : 2);
-            input.erase(0, len); // remove BOM
+            bom_len   = (_encoding == encoding::utf_8 ? 3 : 2); // skip BOM
+        }
+
+        // Valid UTF-8 is decoded to itself, so the input is returned without copying
+        if(_encoding == encoding::utf_8 && bom_len == 0 && output.empty() &&
+           utf_8_valid_prefix_length(input.data(), input.size()) == input.size())
+        {
+            output = std::move(input);
+            return;
         }
 
         // 3.
+        output.reserve(output.size() + input.size());
         auto decoder = get_decoder(_encoding);
-        decoder->process_a_queue(input, output, error_mode::replacement);
+        decoder->process_a_queue(input, bom_len, output, error_mode::replacement);
     }
 
     std::string decode(std::string input, encoding encoding)
@@ -202,8 +321,21 @@ namespace litehtml
         int m_upper_boundary = 0xBF;
 
         result handler(std::string& input, int& index, int ch[2]) override;
+        void   bulk_decode(const std::string& input, int& index, std::string& output) override;
     };
 
+    // Copies the valid UTF-8 sequences, the handler takes over at the first invalid or incomplete sequence.
+    void utf_8_decoder::bulk_decode(const std::string& input, int& index, std::string& output)
+    {
+        if(m_bytes_needed != 0)
+        {
+            return;
+        }
+        size_t len = utf_8_valid_prefix_length(input.data() + index, input.size() - index);
+        output.append(input, index, len);
+        index += static_cast<int>(len);
+    }
+
     // https://encoding.spec.whatwg.org/#utf-8-decoder
     decoder::result utf_8_decoder::handler(inout std::string& input, inout int& index, out int ch[2])
     {
@@ -326,6 +458,7 @@ namespace litehtml
         }
 
         result handler(std::string& input, int& index, int ch[2]) override;
+        void   bulk_decode(const std::string& input, int& index, std::string& output) override;
 
         static int* m_indexes[static_cast<int>(encoding::x_mac_cyrillic) - static_cast<int>(encoding::ibm866) + 1];
 
@@ -627,6 +760,31 @@ namespace litehtml
         return result_codepoint;
     }
 
+    // Copies the ASCII runs and maps the other bytes through the index. Stops at the byte having no code point.
+    void single_byte_decoder::bulk_decode(const std::string& input, int& index, std::string& output)
+    {
+        const char* data = input.data();
+        size_t      size = input.size();
+        size_t      pos  = index;
+        while(pos < size)
+        {
+            size_t len = ascii_prefix_length(data + pos, size - pos);
+            output.append(data + pos, len);
+            pos += len;
+            for(; pos < size && (data[pos] & 0x80); pos++)
+            {
+                int code_point = m_index[static_cast<byte>(data[pos]) - 0x80];
+                if(code_point == null)
+                {
+                    index = static_cast<int>(pos);
+                    return;
+                }
+                append_char(output, code_point);
+            }
+        }
+        index = static_cast<int>(pos);
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
     struct gb18030_decoder final : decoder
@@ -7874,9 +8032,14 @@ namespace litehtml
     }
 
     // see step 5 of https://html.spec.whatwg.org/multipage/parsing.html#encoding-sniffing-algorithm
-    bool end_condition(int index)
+    // The standard prescan stops after 1024 bytes. prescan_for_encoding scans up to head_prescan_size bytes of
+    // <head> if nothing is found there.
+    static const int prescan_size      = 1024;
+    static const int head_prescan_size = static_cast<int>(encoding_sniffing_size);
+
+    bool end_condition(int index, int limit)
     {
-        return index >= 1024;
+        return index >= limit;
     }
 
     struct abort_prescan_exception : public std::exception
@@ -7887,22 +8050,23 @@ namespace litehtml
         }
     };
 
-    void increment(int& index, const std::string& str)
+    void increment(int& index, const std::string& str, int limit)
     {
         index++;
-        if(index >= static_cast<int>(str.size()) || end_condition(index))
+        if(index >= static_cast<int>(str.size()) || end_condition(index, limit))
         {
             throw abort_prescan_exception(); // abort prescan
         }
     }
 
     // https://html.spec.whatwg.org/multipage/parsing.html#concept-get-attributes-when-sniffing
-    bool prescan_get_attribute(const std::string& str, inout int& index, out std::string& name, out std::string& value)
+    bool prescan_get_attribute(const std::string& str, int limit, inout int& index, out std::string& name,
+                               out std::string& value)
     {
         // 1.
         while(is_whitespace(str[index]) || str[index] == '/')
         {
-            increment(index, str);
+            increment(index, str, limit);
         }
 
         // 2.
@@ -7918,7 +8082,7 @@ namespace litehtml
     step_4:
         if(str[index] == '=' && name != "")
         {
-            increment(index, str);
+            increment(index, str, limit);
             goto process_value;
         } else if(is_whitespace(str[index]))
         {
@@ -7932,14 +8096,14 @@ namespace litehtml
         }
 
         // 5.
-        increment(index, str);
+        increment(index, str, limit);
         goto step_4;
 
         // 6.
     spaces:
         while(is_whitespace(str[index]))
         {
-            increment(index, str);
+            increment(index, str, limit);
         }
 
         // 7.
@@ -7949,13 +8113,13 @@ namespace litehtml
         }
 
         // 8.
-        increment(index, str); // skip '='
+        increment(index, str, limit); // skip '='
 
         // 9.
     process_value:
         while(is_whitespace(str[index]))
         {
-            increment(index, str);
+            increment(index, str, limit);
         }
 
         // 10.
@@ -7966,12 +8130,12 @@ namespace litehtml
 
             // 2.
         quote_loop:
-            increment(index, str);
+            increment(index, str, limit);
 
             // 3.
             if(str[index] == b)
             {
-                increment(index, str);
+                increment(index, str, limit);
                 return true;
             }
 
@@ -8000,12 +8164,12 @@ namespace litehtml
         }
 
         // 12.
-        increment(index, str);
+        increment(index, str, limit);
         goto step_11;
     }
 
     // https://html.spec.whatwg.org/multipage/parsing.html#prescan-a-byte-stream-to-determine-its-encoding
-    encoding prescan_a_byte_stream_to_determine_its_encoding(const std::string& str)
+    encoding prescan_a_byte_stream_to_determine_its_encoding(const std::string& str, int limit)
     {
         // 1. Let fallback encoding be null. - bogus, never used
         // 2. Let position be a pointer to a byte in the input byte stream, initially pointing at the first byte.
@@ -8026,7 +8190,7 @@ namespace litehtml
         if(match(str, index, "<!--"))
         {
             index = static_cast<int>(str.find("-->", index));
-            if(index == -1 || end_condition(index))
+            if(index == -1 || end_condition(index, limit))
             {
                 throw abort_prescan_exception(); // abort prescan
             }
@@ -8046,7 +8210,7 @@ namespace litehtml
             // 6.
         attributes:
             std::string attr_name, attr_value;
-            if(!prescan_get_attribute(str, index, attr_name, attr_value))
+            if(!prescan_get_attribute(str, limit, index, attr_name, attr_value))
             {
                 goto processing;
             }
@@ -8121,21 +8285,21 @@ namespace litehtml
         {
             // 1.
             index = static_cast<int>(str.find_first_of(" \t\r\n\f>", index));
-            if(index == -1 || end_condition(index))
+            if(index == -1 || end_condition(index, limit))
             {
                 throw abort_prescan_exception(); // abort prescan
             }
 
             // 2.
             std::string tmp;
-            while(prescan_get_attribute(str, index, tmp, tmp))
+            while(prescan_get_attribute(str, limit, index, tmp, tmp))
             {
             }
             goto next_byte;
         } else if(str[index] == '<' && is_one_of(str[index + 1], '!', '/', '?'))
         {
             index = static_cast<int>(str.find('>', index));
-            if(index == -1 || end_condition(index))
+            if(index == -1 || end_condition(index, limit))
             {
                 throw abort_prescan_exception(); // abort prescan
             }
@@ -8143,7 +8307,7 @@ namespace litehtml
 
         // 5.
     next_byte:
-        increment(index, str);
+        increment(index, str, limit);
         goto loop;
     }
 
@@ -8243,17 +8407,113 @@ namespace litehtml
         return encoding;
     }
 
+    // The content of these elements is text for the parser, a <meta> in it (e.g. in document.write('...') of a
+    // script) does not change the encoding
+    static const char* const raw_text_elements[] = {"script", "style", "title", "textarea", "xmp", "iframe", "noembed",
+                                                    "noframes"};
+
+    // Returns the name of the raw text element which start tag is at index, or nullptr
+    static const char* raw_text_element_at(const std::string& str, int index)
+    {
+        for(const char* name : raw_text_elements)
+        {
+            int len = static_cast<int>(strlen(name));
+            if(match_i(str, index + 1, name) && index + 1 + len < static_cast<int>(str.size()))
+            {
+                char ch = str[index + 1 + len];
+                if(is_whitespace(ch) || ch == '/' || ch == '>')
+                {
+                    return name;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    // Returns the <head> part of str: up to </head> or <body>, but not farther than max_size bytes. The content of
+    // the raw text elements is replaced with spaces, so the prescan sees only the <meta> elements the parser sees.
+    static std::string get_head_markup(const std::string& str, int max_size)
+    {
+        int         size  = std::min(static_cast<int>(str.size()), max_size);
+        std::string head  = str.substr(0, size);
+        int         index = 0;
+        while(index < size)
+        {
+            if(head[index] != '<')
+            {
+                index++;
+                continue;
+            }
+            if(match(head, index, "<!--"))
+            {
+                // The prescan skips comments itself
+                auto end = head.find("-->", index + 4);
+                if(end == std::string::npos)
+                {
+                    break;
+                }
+                index = static_cast<int>(end) + 3;
+                continue;
+            }
+            if(match_i(head, index, "</head") || match_i(head, index, "<body"))
+            {
+                head.resize(index);
+                break;
+            }
+            const char* name = raw_text_element_at(head, index);
+            if(!name)
+            {
+                index++;
+                continue;
+            }
+            auto start = head.find('>', index);
+            if(start == std::string::npos)
+            {
+                break;
+            }
+            std::string end_tag = std::string("</") + name;
+            int         end     = static_cast<int>(start) + 1;
+            while(end < size && !(head[end] == '<' && match_i(head, end, end_tag)))
+            {
+                head[end++] = ' ';
+            }
+            index = end;
+        }
+        return head;
+    }
+
     // https://html.spec.whatwg.org/multipage/parsing.html#prescan-a-byte-stream-to-determine-its-encoding
     encoding prescan_for_encoding(const std::string& str)
     {
         try
         {
-            return prescan_a_byte_stream_to_determine_its_encoding(str);
+            return prescan_a_byte_stream_to_determine_its_encoding(str, prescan_size);
         }
         catch(abort_prescan_exception&)
         {
-            return get_xml_encoding(str);
         }
+
+        encoding xml_encoding = get_xml_encoding(str);
+        if(xml_encoding != encoding::null)
+        {
+            return xml_encoding;
+        }
+
+        // The <meta> placed after the first 1024 bytes (behind a long <title>, <script> or <style>) is found by the
+        // parser in <head>, then the whole document is decoded and parsed again (see document::parse_html). Scan the
+        // rest of <head> too, so the parser gets the right encoding at once.
+        std::string head = get_head_markup(str, head_prescan_size);
+        if(static_cast<int>(head.size()) > prescan_size)
+        {
+            try
+            {
+                return prescan_a_byte_stream_to_determine_its_encoding(head, static_cast<int>(head.size()));
+            }
+            catch(abort_prescan_exception&)
+            {
+            }
+        }
+        return encoding::null;
     }
 
     // https://html.spec.whatwg.org/multipage/parsing.html#encoding-sniffing-algorithm
@@ -89,12 +89,27 @@ namespace litehtml
         if(_name && _val)
         {
             // attribute names in attribute selector are matched ASCII case-insensitively regardless of document mode
-            std::string name = lowcase(_name);
+            std::string lower_name = lowcase(_name);
+            string_id   name       = find_id(lower_name.c_str());
             // m_attrs has all attribute values, including class and id, in their original case
             // because in attribute selector values are matched case-sensitively even in quirks mode
-            m_attrs[name] = _val;
+            auto attr = std::find_if(m_attrs.begin(), m_attrs.end(),
+                                     [name, &lower_name](const html_attribute& item) {
+                                         return item.name == empty_id ? item.unknown_name == lower_name
+                                                                      : item.name == name;
+                                     });
+            if(attr != m_attrs.end())
+            {
+                attr->value = _val;
+            } else if(name == empty_id)
+            {
+                m_attrs.push_back({empty_id, _val, std::move(lower_name)});
+            } else
+            {
+                m_attrs.push_back({name, _val, {}});
+            }
 
-            if(name == "class")
+            if(name == _class_)
             {
                 std::string val = _val;
                 // class names in class selector (.xxx) are matched ASCII case-insensitively in quirks mode
@@ -102,13 +117,19 @@ namespace litehtml
                 {
                     lcase(val);
                 }
-                m_str_classes = split_string(val, whitespace, "", "");
                 m_classes.clear();
-                for(const auto& cls : m_str_classes)
+                for(const auto& cls : split_string(val, whitespace, "", ""))
                 {
                     m_classes.push_back(_id(cls));
                 }
-            } else if(name == "id")
+                std::sort(m_classes.begin(), m_classes.end());
+                m_classes.erase(std::unique(m_classes.begin(), m_classes.end()), m_classes.end());
+                m_class_mask = 0;
+                for(string_id cls : m_classes)
+                {
+                    m_class_mask |= class_bit(cls);
+                }
+            } else if(name == _id_)
             {
                 std::string val = _val;
                 // ids in id selector (#xxx) are matched ASCII case-insensitively in quirks mode
@@ -121,12 +142,51 @@ namespace litehtml
         }
     }
 
+    string_vector html_tag::str_classes() const
+    {
+        std::string val = get_attr(_class_, "");
+        if(get_document()->mode() == quirks_mode)
+        {
+            lcase(val);
+        }
+        return split_string(val, whitespace, "", "");
+    }
+
+    void html_tag::get_memory_usage(memory_usage_info& usage) const
+    {
+        element::get_memory_usage(usage);
+        usage.dom += sizeof(html_tag) - sizeof(element) - sizeof(style);
+        usage.dom += m_attrs.capacity() * sizeof(html_attribute);
+        for(const auto& attr : m_attrs)
+        {
+            usage.dom += attr.value.capacity() + attr.unknown_name.capacity();
+        }
+        usage.dom    += (m_classes.capacity() + m_pseudo_classes.capacity()) * sizeof(string_id);
+        usage.styles += sizeof(style) + m_style.memory_usage();
+    }
+
     const char* html_tag::get_attr(const char* name, const char* def) const
     {
-        auto attr = m_attrs.find(name);
-        if(attr != m_attrs.end())
+        string_id id = find_id(name);
+        for(const auto& attr : m_attrs)
         {
-            return attr->second.c_str();
+            if(attr.name == empty_id ? attr.unknown_name == name : attr.name == id)
+            {
+                return attr.value.c_str();
+            }
+        }
+        return def;
+    }
+
+    const char* html_tag::get_attr(string_id name, const char* def) const
+    {
+        for(const auto& attr : m_attrs)
+        {
+            // The name was not known to string_id when the attribute was set, it can be known now
+            if(attr.name == empty_id ? attr.unknown_name == _s(name) : attr.name == name)
+            {
+                return attr.value.c_str();
+            }
         }
         return def;
     }
@@ -200,7 +260,7 @@ namespace litehtml
                 if(!r.m_attrs.empty())
                 {
                     const auto& attr = r.m_attrs[0];
-                    if(attr.type == select_class && !(attr.name in m_classes))
+                    if(attr.type == select_class && !has_class(attr.name))
                     {
                         continue;
                     }
@@ -211,7 +271,7 @@ namespace litehtml
 
             if(apply != select_no_match)
             {
-                used_selector::ptr us = std::make_unique<used_selector>(sel, false);
+                used_selector us(sel, false);
 
                 if(sel->is_media_valid())
                 {
@@ -249,7 +309,7 @@ namespace litehtml
                                 add_style(*sel->m_style);
                             }
                         }
-                        us->m_used = true;
+                        us.m_used = true;
                     };
 
                     if(apply & select_match_pseudo_class)
@@ -262,7 +322,7 @@ namespace litehtml
                             } else
                             {
                                 add_style(*sel->m_style);
-                                us->m_used = true;
+                                us.m_used = true;
                             }
                         }
                     } else if((apply & (select_match_with_after | select_match_with_before)))
@@ -271,7 +331,7 @@ namespace litehtml
                     } else
                     {
                         add_style(*sel->m_style);
-                        us->m_used = true;
+                        us.m_used = true;
                     }
                 }
                 m_used_styles.push_back(std::move(us));
@@ -344,7 +404,7 @@ namespace litehtml
             result = value.get<css_token_vector>();
             return true;
         }
-        if(auto _parent = dynamic_cast<html_tag*>(parent().get()))
+        if(auto _parent = dynamic_cast<html_tag*>(parent_ptr()))
         {
             return _parent->get_custom_property(name, result);
         }
@@ -353,7 +413,7 @@ namespace litehtml
 
     void litehtml::html_tag::compute_styles(bool recursive)
     {
-        const char*   style = get_attr("style");
+        const char*   style = get_attr(_style_);
         document::ptr doc   = get_document();
 
         if(style)
@@ -363,7 +423,7 @@ namespace litehtml
 
         m_style.subst_vars(this);
 
-        m_css.compute(this, doc);
+        m_css.compute(this, style_index(m_style), doc);
 
         if(recursive)
         {
@@ -374,6 +434,9 @@ namespace litehtml
         }
     }
 
+    // The properties are read from the snapshot
+    void litehtml::html_tag::restore_state() {}
+
     bool litehtml::html_tag::is_white_space() const
     {
         return false;
@@ -405,7 +468,7 @@ namespace litehtml
         {
             return select_no_match;
         }
-        element::ptr el_parent = parent();
+        element* el_parent = parent_ptr();
         if(selector.m_left)
         {
             if(!el_parent)
@@ -492,7 +555,7 @@ namespace litehtml
             switch(attr.type)
             {
             case select_class:
-                if(!(attr.name in m_classes))
+                if(!has_class(attr.name))
                 {
                     return select_no_match;
                 }
@@ -547,7 +610,7 @@ namespace litehtml
 
     int html_tag::select_pseudoclass(const css_attribute_selector& sel)
     {
-        element::ptr el_parent = parent();
+        element* el_parent = parent_ptr();
 
         switch(sel.name)
         {
@@ -667,7 +730,7 @@ namespace litehtml
     // https://www.w3.org/TR/selectors-4/#attribute-selectors
     int html_tag::select_attribute(const css_attribute_selector& sel) const
     {
-        const char* sz_attr_value = get_attr(_s(sel.name).c_str());
+        const char* sz_attr_value = get_attr(sel.name);
 
         if(!sz_attr_value)
         {
@@ -731,7 +794,7 @@ namespace litehtml
 
     element::ptr html_tag::find_ancestor(const css_selector& selector, bool apply_pseudo, bool* is_pseudo)
     {
-        element::ptr el_parent = parent();
+        element* el_parent = parent_ptr();
         if(!el_parent)
         {
             return nullptr;
@@ -749,7 +812,7 @@ namespace litehtml
                     *is_pseudo = false;
                 }
             }
-            return el_parent;
+            return el_parent->shared_from_this();
         }
         return el_parent->find_ancestor(selector, apply_pseudo, is_pseudo);
     }
@@ -877,20 +940,18 @@ namespace litehtml
     void litehtml::html_tag::draw_background(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
                                              const std::shared_ptr<render_item>& ri)
     {
+        auto&  cache   = ri->background_cache();
+        size_t box_idx = 0;
+
         auto inline_processed = ri->for_inline_boxes([&](const position& box_, bool first, bool last) {
-            const background* bg = get_background();
+            auto bg = get_background_group();
 
-            position content_box;
             position box  = box_;
             box.x        += x;
             box.y        += y;
 
             if(box.does_intersect(clip))
             {
-                content_box  = box;
-                content_box -= ri->get_borders();
-                content_box -= ri->get_paddings();
-
                 css_borders bdr;
 
                 // set left borders radius for the first box
@@ -924,23 +985,32 @@ namespace litehtml
 
                 if(bg)
                 {
-                    int num_layers = bg->get_layers_number();
-                    for(int i = num_layers - 1; i >= 0; i--)
+                    if(cache.size() <= box_idx)
                     {
-                        background_layer layer;
+                        cache.resize(box_idx + 1);
+                    }
+                    auto& item = cache[box_idx];
 
-                        if(!bg->get_layer(i, content_box, this, ri, layer))
-                        {
-                            continue;
-                        }
+                    // Layers are prepared relative to the box position
+                    position rel_box(0_px, 0_px, box_.width, box_.height);
+                    if(!item.is_valid(bg, rel_box))
+                    {
+                        position content_box  = rel_box;
+                        content_box          -= ri->get_borders();
+                        content_box          -= ri->get_paddings();
+
+                        prepare_background(item, bg, rel_box, content_box, ri, &bdr.radius);
+                    }
 
-                        layer.border_radius = bdr.radius.calc_percents(box.width, box.height);
+                    for(auto& prepared : item.layers)
+                    {
+                        background_layer layer = prepared.get_layer(box.x, box.y);
 
                         layer.border_box.round();
                         layer.clip_box.round();
                         layer.origin_box.round();
 
-                        bg->draw_layer(hdc, i, layer, get_document()->container());
+                        prepared.draw(hdc, layer, get_document()->container());
                     }
                 }
                 if(bdr.is_visible())
@@ -951,6 +1021,7 @@ namespace litehtml
                     get_document()->container()->draw_borders(hdc, b, box, false);
                 }
             }
+            box_idx++;
             return true;
         });
 
@@ -966,22 +1037,27 @@ namespace litehtml
 
             if(border_box.does_intersect(clip) || is_root())
             {
-                auto v_offset  = ri->get_draw_vertical_offset();
-                pos.y         += v_offset;
-                pos.height    -= v_offset;
+                auto v_offset = ri->get_draw_vertical_offset();
 
-                const background* bg = get_background();
+                auto bg = get_background_group();
                 if(bg)
                 {
-                    int num_layers = bg->get_layers_number();
-                    for(int i = num_layers - 1; i >= 0; i--)
+                    if(cache.empty())
                     {
-                        background_layer layer;
+                        cache.resize(1);
+                    }
+                    auto& item = cache.front();
 
-                        if(!bg->get_layer(i, pos, this, ri, layer))
-                        {
-                            continue;
-                        }
+                    // Layers are prepared relative to the render item position
+                    position rel_box(0_px, v_offset, pos.width, pos.height - v_offset);
+                    if(!item.is_valid(bg, rel_box))
+                    {
+                        prepare_background(item, bg, rel_box, rel_box, ri, nullptr);
+                    }
+
+                    for(auto& prepared : item.layers)
+                    {
+                        background_layer layer = prepared.get_layer(pos.x, pos.y);
 
                         if(is_root() && (clip != nullptr))
                         {
@@ -993,7 +1069,7 @@ namespace litehtml
                         layer.clip_box.round();
                         layer.origin_box.round();
 
-                        bg->draw_layer(hdc, i, layer, get_document()->container());
+                        prepared.draw(hdc, layer, get_document()->container());
                     }
                 }
 
@@ -1008,6 +1084,39 @@ namespace litehtml
         }
     }
 
+    void litehtml::html_tag::prepare_background(background_cache_item&                   item,
+                                                const std::shared_ptr<const background>& bg, const position& box,
+                                                const position&                          content_box,
+                                                const std::shared_ptr<render_item>&      ri,
+                                                const css_border_radius*                 radius)
+    {
+        item.bg    = bg;
+        item.box   = box;
+        item.valid = true;
+        item.layers.clear();
+
+        int num_layers = bg->get_layers_number();
+        for(int i = num_layers - 1; i >= 0; i--)
+        {
+            background_prepared_layer prepared;
+
+            if(!bg->prepare_layer(i, content_box, this, ri, prepared))
+            {
+                continue;
+            }
+            if(radius)
+            {
+                prepared.layer.border_radius = radius->calc_percents(box.width, box.height);
+            }
+            // Images that are not loaded yet will be resolved on the next draw
+            if(!prepared.complete)
+            {
+                item.valid = false;
+            }
+            item.layers.push_back(std::move(prepared));
+        }
+    }
+
     bool litehtml::html_tag::set_pseudo_class(string_id cls, bool add)
     {
         bool ret = false;
@@ -1037,13 +1146,22 @@ namespace litehtml
 
         split_string(pclass, classes, " ");
 
+        // The names are compared like the class selector does, the class attribute keeps the original case
+        bool          quirks     = get_document()->mode() == quirks_mode;
+        string_vector el_classes = split_string(get_attr(_class_, ""), whitespace, "", "");
+        auto          same_class = [quirks](const std::string& a, const std::string& b)
+        {
+            return quirks ? lowcase(a) == lowcase(b) : a == b;
+        };
+
         if(add)
         {
             for(auto& _class : classes)
             {
-                if(std::find(m_str_classes.begin(), m_str_classes.end(), _class) == m_str_classes.end())
+                if(std::none_of(el_classes.begin(), el_classes.end(),
+                                [&](const std::string& cls) { return same_class(cls, _class); }))
                 {
-                    m_str_classes.push_back(std::move(_class));
+                    el_classes.push_back(std::move(_class));
                     changed = true;
                 }
             }
@@ -1051,11 +1169,12 @@ namespace litehtml
         {
             for(const auto& _class : classes)
             {
-                auto end = std::remove(m_str_classes.begin(), m_str_classes.end(), _class);
+                auto end = std::remove_if(el_classes.begin(), el_classes.end(),
+                                          [&](const std::string& cls) { return same_class(cls, _class); });
 
-                if(end != m_str_classes.end())
+                if(end != el_classes.end())
                 {
-                    m_str_classes.erase(end, m_str_classes.end());
+                    el_classes.erase(end, el_classes.end());
                     changed = true;
                 }
             }
@@ -1064,7 +1183,7 @@ namespace litehtml
         if(changed)
         {
             std::string class_string;
-            join_string(class_string, m_str_classes, " ");
+            join_string(class_string, el_classes, " ");
             set_attr("class", class_string.c_str());
 
             return true;
@@ -1106,7 +1225,7 @@ namespace litehtml
             lm.pos.y         = li_baseline - css().get_font_metrics().ascent;
             lm.pos.height    = css().get_font_metrics().height;
 
-            lm.index = atoi(get_attr("list_index", "0"));
+            lm.index = ri->list_index();
         } else
         {
             lm.pos.height = sz_font / 3_px;
@@ -1456,62 +1575,83 @@ namespace litehtml
 
         for(auto& usel : m_used_styles)
         {
-            usel->m_used = false;
+            usel.m_used = false;
 
-            if(usel->m_selector->is_media_valid())
+            if(usel.m_selector->is_media_valid())
             {
-                int apply = select(*usel->m_selector, false);
+                int apply = select(*usel.m_selector, false);
 
                 if(apply != select_no_match)
                 {
                     if(apply & select_match_pseudo_class)
                     {
-                        if(select(*usel->m_selector, true))
+                        if(select(*usel.m_selector, true))
                         {
                             if(apply & select_match_with_after)
                             {
-                                element::ptr el = get_element_after(*usel->m_selector->m_style, false);
+                                element::ptr el = get_element_after(*usel.m_selector->m_style, false);
                                 if(el)
                                 {
-                                    el->add_style(*usel->m_selector->m_style);
+                                    el->add_style(*usel.m_selector->m_style);
                                 }
                             } else if(apply & select_match_with_before)
                             {
-                                element::ptr el = get_element_before(*usel->m_selector->m_style, false);
+                                element::ptr el = get_element_before(*usel.m_selector->m_style, false);
                                 if(el)
                                 {
-                                    el->add_style(*usel->m_selector->m_style);
+                                    el->add_style(*usel.m_selector->m_style);
                                 }
                             } else
                             {
-                                add_style(*usel->m_selector->m_style);
-                                usel->m_used = true;
+                                add_style(*usel.m_selector->m_style);
+                                usel.m_used = true;
                             }
                         }
                     } else if(apply & select_match_with_after)
                     {
-                        element::ptr el = get_element_after(*usel->m_selector->m_style, false);
+                        element::ptr el = get_element_after(*usel.m_selector->m_style, false);
                         if(el)
                         {
-                            el->add_style(*usel->m_selector->m_style);
+                            el->add_style(*usel.m_selector->m_style);
                         }
                     } else if(apply & select_match_with_before)
                     {
-                        element::ptr el = get_element_before(*usel->m_selector->m_style, false);
+                        element::ptr el = get_element_before(*usel.m_selector->m_style, false);
                         if(el)
                         {
-                            el->add_style(*usel->m_selector->m_style);
+                            el->add_style(*usel.m_selector->m_style);
                         }
                     } else
                     {
-                        add_style(*usel->m_selector->m_style);
-                        usel->m_used = true;
+                        add_style(*usel.m_selector->m_style);
+                        usel.m_used = true;
                     }
                 }
             }
         }
     }
 
+    void litehtml::html_tag::refresh_media_styles(const media_query_list_list::vector& changed)
+    {
+        for(const auto& usel : m_used_styles)
+        {
+            if(usel.m_selector->m_media_query && contains(changed, usel.m_selector->m_media_query))
+            {
+                // The children inherit the changed properties, so the whole subtree is restyled
+                refresh_styles();
+                compute_styles();
+                return;
+            }
+        }
+        for(auto& el : m_children)
+        {
+            if(el->css().get_display() != display_inline_text)
+            {
+                el->refresh_media_styles(changed);
+            }
+        }
+    }
+
     const litehtml::background* litehtml::html_tag::get_background(bool own_only)
     {
         if(own_only)
@@ -1523,7 +1663,11 @@ namespace litehtml
             }
             return &m_css.get_bg();
         }
+        return get_background_group().get();
+    }
 
+    std::shared_ptr<const background> html_tag::get_background_group()
+    {
         if(m_css.get_bg().is_empty())
         {
             // if this is root element (<html>) try to get background from body
@@ -1534,7 +1678,8 @@ namespace litehtml
                     if(el->is_body())
                     {
                         // return own body background
-                        return el->get_background(true);
+                        const auto& bg = el->css().get_bg_group();
+                        return bg->is_empty() ? nullptr : bg;
                     }
                 }
             }
@@ -1554,7 +1699,7 @@ namespace litehtml
             }
         }
 
-        return &m_css.get_bg();
+        return m_css.get_bg_group();
     }
 
     std::string html_tag::dump_get_name()
@@ -231,6 +231,119 @@ namespace litehtml
         return ret;
     }
 
+    void media_query_list_list::collect_breakpoints(media_breakpoints& breakpoints) const
+    {
+        for(const auto& mq_list : m_media_query_lists)
+        {
+            mq_list.collect_breakpoints(breakpoints);
+        }
+    }
+
+    void media_query_list::collect_breakpoints(media_breakpoints& breakpoints) const
+    {
+        for(const auto& query : m_queries)
+        {
+            query.collect_breakpoints(breakpoints);
+        }
+    }
+
+    void media_query::collect_breakpoints(media_breakpoints& breakpoints) const
+    {
+        for(const auto& condition : m_conditions)
+        {
+            condition.collect_breakpoints(breakpoints);
+        }
+    }
+
+    void media_condition::collect_breakpoints(media_breakpoints& breakpoints) const
+    {
+        for(const auto& condition : m_conditions)
+        {
+            condition.collect_breakpoints(breakpoints);
+        }
+    }
+
+    void media_in_parens::collect_breakpoints(media_breakpoints& breakpoints) const
+    {
+        if(is<media_condition>())
+        {
+            get<media_condition>().collect_breakpoints(breakpoints);
+        } else if(is<media_feature>())
+        {
+            get<media_feature>().collect_breakpoints(breakpoints);
+        }
+    }
+
+    // The other features don't depend on the viewport size, media_breakpoints::same_results compares them directly
+    void media_feature::collect_breakpoints(media_breakpoints& breakpoints) const
+    {
+        std::vector<float>* points;
+        switch(_id(name))
+        {
+        case _width_:
+            points = &breakpoints.width;
+            break;
+        case _height_:
+            points = &breakpoints.height;
+            break;
+        case _orientation_:
+        case _aspect_ratio_:
+            breakpoints.size_ratio = true;
+            return;
+        default:
+            return;
+        }
+        points->push_back(value);
+        if(op2)
+        {
+            points->push_back(value2);
+        }
+    }
+
+    void media_breakpoints::clear()
+    {
+        width.clear();
+        height.clear();
+        size_ratio = false;
+    }
+
+    void media_breakpoints::sort()
+    {
+        for(auto* points : {&width, &height})
+        {
+            std::sort(points->begin(), points->end());
+            points->erase(std::unique(points->begin(), points->end()), points->end());
+        }
+    }
+
+    // Returns true if there is no breakpoint between a and b, including the ends: the comparisons with the
+    // breakpoint itself can give any result.
+    static bool same_interval(const std::vector<float>& points, pixel_t a, pixel_t b)
+    {
+        if(a == b)
+        {
+            return true;
+        }
+        const float epsilon = 0.01f;
+        auto        iter    = std::lower_bound(points.begin(), points.end(), std::min(a, b).value() - epsilon);
+        return iter == points.end() || *iter > std::max(a, b).value() + epsilon;
+    }
+
+    bool media_breakpoints::same_results(const media_features& a, const media_features& b) const
+    {
+        if(a.type != b.type || a.device_width != b.device_width || a.device_height != b.device_height ||
+           a.color != b.color || a.color_index != b.color_index || a.monochrome != b.monochrome ||
+           a.resolution != b.resolution)
+        {
+            return false;
+        }
+        if(size_ratio && (a.width != b.width || a.height != b.height))
+        {
+            return false;
+        }
+        return same_interval(width, a.width, b.width) && same_interval(height, a.height, b.height);
+    }
+
     bool parse_media_query(const css_token_vector& tokens, media_query& mquery, const std::shared_ptr<document>& doc);
 
     // https://drafts.csswg.org/mediaqueries-5/#typedef-media-query-list
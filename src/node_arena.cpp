@@ -0,0 +1,74 @@
+#include "html.h"
+#include "node_arena.h"
+
+#ifndef LITEHTML_NO_THREADS
+#define lock_guard std::lock_guard<std::mutex> lock(m_mutex)
+#else
+#define lock_guard
+#endif
+
+namespace litehtml
+{
+    void* node_arena::allocate(size_t size)
+    {
+        if(size == 0)
+        {
+            size = 1;
+        }
+        if(size > max_pooled)
+        {
+            lock_guard;
+            m_used_bytes += size;
+            return ::operator new(size);
+        }
+
+        size_t cls = size_class(size);
+        lock_guard;
+        m_used_bytes += (cls + 1) * granularity;
+        if(free_block* block = m_free[cls])
+        {
+            m_free[cls] = block->next;
+            return block;
+        }
+
+        size_t bytes = (cls + 1) * granularity;
+        if(static_cast<size_t>(m_end - m_pos) < bytes)
+        {
+            // The rest of the chunk is lost, it is smaller than the block
+            m_chunks.emplace_back(new char[chunk_size]);
+            m_pos = m_chunks.back().get();
+            m_end = m_pos + chunk_size;
+        }
+        void* ret  = m_pos;
+        m_pos     += bytes;
+        return ret;
+    }
+
+    void node_arena::deallocate(void* ptr, size_t size)
+    {
+        if(!ptr)
+        {
+            return;
+        }
+        if(size == 0)
+        {
+            size = 1;
+        }
+        if(size > max_pooled)
+        {
+            {
+                lock_guard;
+                m_used_bytes -= size;
+            }
+            ::operator delete(ptr);
+            return;
+        }
+
+        size_t cls = size_class(size);
+        lock_guard;
+        m_used_bytes -= (cls + 1) * granularity;
+        auto* block   = static_cast<free_block*>(ptr);
+        block->next   = m_free[cls];
+        m_free[cls]   = block;
+    }
+} // namespace litehtml
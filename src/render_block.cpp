@@ -56,17 +56,18 @@ std::shared_ptr<litehtml::render_item> litehtml::render_item_block::init()
     std::shared_ptr<render_item> ret;
 
     // Initialize indexes for list items
+    int list_index = 0;
     if(src_el()->css().get_display() == display_list_item &&
        src_el()->css().get_list_style_type() >= list_style_type_armenian)
     {
         if(auto p = src_el()->parent())
         {
-            int val = atoi(p->get_attr("start", "1"));
+            int val = atoi(p->get_attr(_start_, "1"));
             for(const auto& child : p->children())
             {
                 if(child == src_el())
                 {
-                    src_el()->set_attr("list_index", std::to_string(val).c_str());
+                    list_index = val;
                     break;
                 }
                 if(child->css().get_display() == display_list_item)
@@ -121,7 +122,7 @@ std::shared_ptr<litehtml::render_item> litehtml::render_item_block::init()
     }
     if(has_block_level)
     {
-        ret = std::make_shared<render_item_block_context>(src_el());
+        ret = make_node<render_item_block_context>(src_el()->get_arena(), src_el());
         ret->parent(parent());
 
         auto                 doc = src_el()->get_document();
@@ -141,8 +142,8 @@ std::shared_ptr<litehtml::render_item> litehtml::render_item_block::init()
             {
                 if(not_ws_added)
                 {
-                    auto anon_el = std::make_shared<html_tag>(src_el());
-                    auto anon_ri = std::make_shared<render_item_block>(anon_el);
+                    auto anon_el = make_node<html_tag>(src_el()->get_arena(), src_el());
+                    auto anon_ri = make_node<render_item_block>(src_el()->get_arena(), anon_el);
                     for(const auto& inl : inlines)
                     {
                         anon_ri->add_child(inl);
@@ -159,8 +160,8 @@ std::shared_ptr<litehtml::render_item> litehtml::render_item_block::init()
         }
         if(!inlines.empty() && not_ws_added)
         {
-            auto anon_el = std::make_shared<html_tag>(src_el());
-            auto anon_ri = std::make_shared<render_item_block>(anon_el);
+            auto anon_el = make_node<html_tag>(src_el()->get_arena(), src_el());
+            auto anon_ri = make_node<render_item_block>(src_el()->get_arena(), anon_el);
             for(const auto& inl : inlines)
             {
                 anon_ri->add_child(inl);
@@ -174,7 +175,7 @@ std::shared_ptr<litehtml::render_item> litehtml::render_item_block::init()
 
     if(!ret)
     {
-        ret = std::make_shared<render_item_inline_context>(src_el());
+        ret = make_node<render_item_inline_context>(src_el()->get_arena(), src_el());
         ret->parent(parent());
         ret->children() = children();
         for(const auto& el : ret->children())
@@ -183,6 +184,7 @@ std::shared_ptr<litehtml::render_item> litehtml::render_item_block::init()
         }
     }
 
+    ret->list_index(list_index);
     ret->src_el()->add_render(ret);
 
     for(auto& el : ret->children())
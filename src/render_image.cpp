@@ -21,7 +21,11 @@ litehtml::rendered_width litehtml::render_item_image::_render(pixel_t x, pixel_t
     m_pos.width  = sz.width;
     m_pos.height = sz.height;
 
-    src_el()->css_w().line_height_w().computed_value = height();
+    // line_height_w() copies the font group, it is changed only if the height is new
+    if(src_el()->css().line_height().computed_value != height())
+    {
+        src_el()->css_w().line_height_w().computed_value = height();
+    }
 
     if(src_el()->css().get_height().is_predefined() && src_el()->css().get_width().is_predefined())
     {
@@ -377,3 +377,13 @@ litehtml::pixel_t litehtml::render_item_inline_context::get_last_baseline()
     }
     return bl;
 }
+
+void litehtml::render_item_inline_context::get_memory_usage(memory_usage_info& usage) const
+{
+    render_item_block::get_memory_usage(usage);
+    usage.render_tree += sizeof(render_item_inline_context) - sizeof(render_item);
+    for(const auto& lb : m_line_boxes)
+    {
+        usage.render_tree += sizeof(line_box) + lb->items().size() * sizeof(line_box_item);
+    }
+}
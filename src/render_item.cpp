@@ -1,6 +1,7 @@
 #include "render_item.h"
 #include "document.h"
 #include "document_container.h"
+#include "el_text.h"
 #include "types.h"
 #include <algorithm>
 #include <typeinfo>
@@ -8,8 +9,8 @@
 litehtml::render_item::render_item(std::shared_ptr<element> _src_el) :
     m_element(std::move(_src_el))
 {
-    document::ptr doc = src_el()->get_document();
-    auto          fm  = css().get_font_metrics();
+    document* doc = src_el()->document_ptr();
+    auto      fm  = css().get_font_metrics();
 
     m_margins.left   = doc->to_pixels(src_el()->css().get_margins().left, fm, 0_px);
     m_margins.right  = doc->to_pixels(src_el()->css().get_margins().right, fm, 0_px);
@@ -27,11 +28,23 @@ litehtml::render_item::render_item(std::shared_ptr<element> _src_el) :
     m_borders.bottom = doc->to_pixels(src_el()->css().get_borders().bottom.width, fm, 0_px);
 }
 
+litehtml::render_item::~render_item()
+{
+    for(const auto& child : m_children)
+    {
+        if(child->m_parent_ptr == this)
+        {
+            child->m_parent_ptr = nullptr;
+        }
+    }
+}
+
 litehtml::rendered_width litehtml::render_item::render(pixel_t x, pixel_t y,
                                                        const containing_block_context& containing_block_size,
                                                        formatting_context* fmt_ctx, bool second_pass)
 {
     calc_outlines(containing_block_size.width);
+    clear_background_cache();
 
     m_pos.clear();
     m_pos.move_to(x, y);
@@ -787,7 +800,7 @@ void litehtml::render_item::add_positioned(const std::shared_ptr<litehtml::rende
         m_positioned.push_back(el);
     } else
     {
-        auto el_parent = parent();
+        auto* el_parent = parent_ptr();
         if(el_parent)
         {
             el_parent->add_positioned(el);
@@ -840,6 +853,11 @@ void litehtml::render_item::calc_document_size(litehtml::size& sz, pixel_t x /*=
                 sz.height = std::max(sz.height, y + bottom());
             }
 
+            if(src_el()->css().get_overflow() > overflow_visible)
+            {
+                m_content_inside = is_content_inside(position(0_px, 0_px, m_pos.width, m_pos.height), 0_px, 0_px);
+            }
+
             if(is_one_of(src_el()->css().get_overflow(), overflow_scroll, overflow_auto))
             {
                 size child_size;
@@ -877,6 +895,73 @@ void litehtml::render_item::calc_document_size(litehtml::size& sz, pixel_t x /*=
     }
 }
 
+bool litehtml::render_item::is_content_inside(const position& box, pixel_t x, pixel_t y) const
+{
+    auto is_inside = [&box](const position& pos) {
+        return pos.left() >= box.left() && pos.right() <= box.right() && pos.top() >= box.top() &&
+               pos.bottom() <= box.bottom();
+    };
+
+    for(const auto& el : m_children)
+    {
+        if(!el->is_visible())
+        {
+            continue;
+        }
+        const auto& el_css = el->src_el()->css();
+        // Fixed elements and outside list markers are drawn outside the parent box
+        if(el_css.get_position() == element_position_fixed ||
+           (el_css.get_display() == display_list_item && el_css.get_list_style_position() == list_style_position_outside))
+        {
+            return false;
+        }
+
+        bool inside           = true;
+        auto inline_processed = el->for_inline_boxes([&](const position& box_, bool, bool) {
+            position pos  = box_;
+            pos.x        += x;
+            pos.y        += y;
+            inside        = is_inside(pos);
+            return inside;
+        });
+        if(!inline_processed)
+        {
+            position pos  = el->m_pos;
+            pos.x        += x;
+            pos.y        += y;
+            pos          += el->m_padding;
+            pos          += el->m_borders;
+            inside        = is_inside(pos);
+        }
+        if(!inside)
+        {
+            return false;
+        }
+
+        // The content of the child with overflow other than visible is clipped by the child box
+        if(el_css.get_overflow() == overflow_visible && !el->is_content_inside(box, x + el->m_pos.x, y + el->m_pos.y))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void litehtml::render_item::get_memory_usage(memory_usage_info& usage) const
+{
+    usage.render_tree += sizeof(render_item) + m_children.capacity() * sizeof(std::shared_ptr<render_item>) +
+                         m_positioned.capacity() * sizeof(std::shared_ptr<render_item>) +
+                         m_background_cache.capacity() * sizeof(background_cache_item);
+    for(const auto& item : m_background_cache)
+    {
+        usage.render_tree += item.layers.capacity() * sizeof(background_prepared_layer::vector::value_type);
+    }
+    for(const auto& el : m_children)
+    {
+        el->get_memory_usage(usage);
+    }
+}
+
 void litehtml::render_item::draw_stacking_context(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
                                                   bool with_positioned)
 {
@@ -924,41 +1009,247 @@ void litehtml::render_item::draw_stacking_context(uint_ptr hdc, pixel_t x, pixel
     }
 }
 
+void litehtml::render_item::collect_layers(std::vector<std::shared_ptr<render_item>>& layers, layer_type parent_layer)
+{
+    for(const auto& el : m_children)
+    {
+        el->m_layer = layer_type_none;
+        if(el->is_visible())
+        {
+            // Fixed elements are composited relative to the viewport, so they start a layer even inside a scroll
+            // layer. Nested scroll boxes are drawn into the layer of the outer one. Layers are composited over the
+            // document, so the fixed elements with negative z-index are drawn with the document.
+            if(el->src_el()->css().get_position() == element_position_fixed)
+            {
+                if(parent_layer != layer_type_fixed && el->src_el()->css().get_z_index() >= 0)
+                {
+                    el->m_layer = layer_type_fixed;
+                }
+            } else if(el->m_scroll_view && parent_layer == layer_type_document &&
+                      is_one_of(el->src_el()->css().get_overflow(), overflow_scroll, overflow_auto) &&
+                      el->src_el()->css().get_display() != display_inline)
+            {
+                el->m_layer = layer_type_scroll;
+            }
+        }
+        if(el->m_layer != layer_type_none)
+        {
+            layers.push_back(el);
+            el->collect_layers(layers, el->m_layer);
+        } else if(el->src_el()->css().get_position() == element_position_fixed)
+        {
+            // The content of the fixed element is drawn with it
+            el->collect_layers(layers, layer_type_fixed);
+        } else
+        {
+            el->collect_layers(layers, parent_layer);
+        }
+    }
+}
+
+bool litehtml::render_item::is_overlapped_by_positioned(const render_item* layer, const position& box,
+                                                          bool& layer_found) const
+{
+    for(const auto& el : m_children)
+    {
+        if(el.get() == layer)
+        {
+            layer_found = true;
+            continue;
+        }
+        if(el->m_layer == layer_type_fixed || !el->is_visible())
+        {
+            continue;
+        }
+        bool in_child = false;
+        if(el->is_overlapped_by_positioned(layer, box, in_child))
+        {
+            return true;
+        }
+        if(in_child)
+        {
+            // The ancestors of the layer are drawn under its content
+            layer_found = true;
+        } else if(el->src_el()->is_positioned() && el->css().get_z_index() >= 0)
+        {
+            // The padding, borders and overflowing content of the element are drawn over the layer too, so test
+            // the redraw box. get_redraw_box() takes the position of the parent content box.
+            position placement = el->get_placement();
+            position drawn     = placement;
+            el->get_redraw_box(drawn, placement.x - el->pos().x, placement.y - el->pos().y);
+            if(drawn.does_intersect(&box, true))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void litehtml::render_item::get_layer_info(layer_info& info)
+{
+    info.id      = reinterpret_cast<uint_ptr>(this); // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+    info.type    = m_layer;
+    info.z_index = css().get_z_index();
+    if(m_layer == layer_type_scroll && m_scroll_view)
+    {
+        info.box          = get_placement();
+        info.content_size = m_scroll_view->get_scroll_size();
+        info.scroll_left  = m_scroll_view->get_left();
+        info.scroll_top   = m_scroll_view->get_top();
+    } else
+    {
+        // The same box is reported by document::get_fixed_boxes()
+        info.box = m_pos;
+        get_redraw_box(info.box);
+        info.content_size = size(info.box.width, info.box.height);
+    }
+    info.content_size.width  = std::max(info.content_size.width, info.box.width);
+    info.content_size.height = std::max(info.content_size.height, info.box.height);
+}
+
+void litehtml::render_item::draw_layer(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip)
+{
+    if(m_layer == layer_type_fixed)
+    {
+        src_el()->draw(hdc, x, y, clip, shared_from_this());
+        draw_stacking_context(hdc, x, y, clip, true);
+    } else if(m_layer == layer_type_scroll && is_visible())
+    {
+        // Positioned descendants having the containing block outside the scroll box are drawn with the layer
+        // content, so collect the z-indexes of the whole subtree, not only of m_positioned.
+        std::map<int, bool>                                      z_indexes;
+        std::function<void(const std::shared_ptr<render_item>&)> add_z_indexes;
+        add_z_indexes = [&](const std::shared_ptr<render_item>& el) {
+            for(const auto& child : el->m_children)
+            {
+                if(child->src_el()->is_positioned())
+                {
+                    z_indexes[child->src_el()->css().get_z_index()];
+                } else
+                {
+                    add_z_indexes(child);
+                }
+            }
+        };
+        add_z_indexes(shared_from_this());
+
+        x -= m_pos.x;
+        y -= m_pos.y;
+        for(const auto& idx : z_indexes)
+        {
+            if(idx.first < 0)
+            {
+                draw_children(hdc, x, y, clip, draw_positioned, idx.first);
+            }
+        }
+        draw_children(hdc, x, y, clip, draw_block, 0);
+        draw_children(hdc, x, y, clip, draw_floats, 0);
+        draw_children(hdc, x, y, clip, draw_inlines, 0);
+        for(const auto& idx : z_indexes)
+        {
+            if(idx.first >= 0)
+            {
+                draw_children(hdc, x, y, clip, draw_positioned, idx.first);
+            }
+        }
+    }
+}
+
 void litehtml::render_item::draw_children(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip, draw_flag flag,
                                           int zindex)
 {
-    position pos  = m_pos;
-    pos.x        += x - get_scroll_left();
-    pos.y        += y - get_scroll_top();
-
     document::ptr doc = src_el()->get_document();
 
-    if(src_el()->css().get_overflow() > overflow_visible)
+    position pos = m_pos;
+    if(m_layer == layer_type_scroll && doc->is_layer_drawn(this))
+    {
+        // The scroll layer is rasterized without the scroll shift and clipped by the compositor
+        pos.x += x;
+        pos.y += y;
+    } else
+    {
+        if(m_layer == layer_type_scroll && doc->is_layer_hidden(this))
+        {
+            return;
+        }
+        pos.x += x - get_scroll_left();
+        pos.y += y - get_scroll_top();
+    }
+
+    // TODO: Process overflow for inline elements
+    bool     apply_clip = src_el()->css().get_overflow() > overflow_visible &&
+                      src_el()->css().get_display() != display_inline && !doc->is_layer_drawn(this);
+    position children_clip;
+
+    if(apply_clip)
     {
-        // TODO: Process overflow for inline elements
-        if(src_el()->css().get_display() != display_inline)
+        position clip_box  = m_pos;
+        clip_box.x        += x;
+        clip_box.y        += y;
+
+        // Nothing can be drawn outside the clip box, so the children get the intersected clip
+        if(clip)
         {
-            position clip_box    = m_pos;
-            clip_box.x          += x;
-            clip_box.y          += y;
-            position border_box  = clip_box;
-            border_box          += m_padding;
-            border_box          += m_borders;
+            children_clip = clip->intersect(clip_box);
+            if(children_clip.width <= 0_px || children_clip.height <= 0_px)
+            {
+                return;
+            }
+        } else
+        {
+            children_clip = clip_box;
+        }
+        clip = &children_clip;
+
+        position border_box  = clip_box;
+        border_box          += m_padding;
+        border_box          += m_borders;
 
-            border_radiuses bdr_radius =
-                src_el()->css().get_borders().radius.calc_percents(border_box.width, border_box.height);
+        border_radiuses bdr_radius =
+            src_el()->css().get_borders().radius.calc_percents(border_box.width, border_box.height);
 
-            bdr_radius -= m_borders;
-            bdr_radius -= m_padding;
+        bdr_radius -= m_borders;
+        bdr_radius -= m_padding;
 
+        // The clip is not required if the content fits into the rectangular box
+        if(m_content_inside && bdr_radius.is_zero())
+        {
+            apply_clip = false;
+        } else
+        {
             doc->container()->set_clip(clip_box, bdr_radius);
         }
     }
 
+    text_run run;
+    bool     use_runs = flag == draw_inlines && doc->container()->draw_text_runs();
+
     for(const auto& el : m_children)
     {
         if(el->is_visible())
         {
+            if(use_runs)
+            {
+                auto text_el = el->src_el()->is_text() && !el->src_el()->is_positioned()
+                                   ? dynamic_cast<el_text*>(el->src_el().get())
+                                   : nullptr;
+                if(text_el)
+                {
+                    if(!text_el->add_to_run(run, pos.x, pos.y, el))
+                    {
+                        run.flush(hdc, clip, doc->container());
+                        if(!text_el->add_to_run(run, pos.x, pos.y, el))
+                        {
+                            text_el->draw(hdc, pos.x, pos.y, clip, el);
+                        }
+                    }
+                    continue;
+                }
+                // Keep the drawing order of the text and the other elements
+                run.flush(hdc, clip, doc->container());
+            }
+
             bool process = true;
             switch(flag)
             {
@@ -968,8 +1259,11 @@ void litehtml::render_item::draw_children(uint_ptr hdc, pixel_t x, pixel_t y, co
                     if(el->src_el()->css().get_position() == element_position_fixed)
                     {
                         // Fixed elements position is always relative to the (0,0)
-                        el->src_el()->draw(hdc, 0_px, 0_px, clip, el);
-                        el->draw_stacking_context(hdc, 0_px, 0_px, clip, true);
+                        if(!doc->is_layer_hidden(el.get()))
+                        {
+                            el->src_el()->draw(hdc, 0_px, 0_px, clip, el);
+                            el->draw_stacking_context(hdc, 0_px, 0_px, clip, true);
+                        }
                     } else
                     {
                         el->src_el()->draw(hdc, pos.x, pos.y, clip, el);
@@ -1029,8 +1323,9 @@ void litehtml::render_item::draw_children(uint_ptr hdc, pixel_t x, pixel_t y, co
             }
         }
     }
+    run.flush(hdc, clip, doc->container());
 
-    if(src_el()->css().get_overflow() > overflow_visible)
+    if(apply_clip)
     {
         doc->container()->del_clip();
     }
@@ -1312,7 +1607,7 @@ void litehtml::render_item::get_rendering_boxes(const std::function<void(const p
 
     if(src_el()->css().get_position() != element_position_fixed)
     {
-        auto cur_el = parent();
+        auto* cur_el = parent_ptr();
 
         while(cur_el)
         {
@@ -1326,7 +1621,7 @@ void litehtml::render_item::get_rendering_boxes(const std::function<void(const p
             }
             add_x  += cur_el->m_pos.x - cur_el->get_scroll_left();
             add_y  += cur_el->m_pos.y - cur_el->get_scroll_top();
-            cur_el  = cur_el->parent();
+            cur_el  = cur_el->parent_ptr();
         }
     } else
     {
@@ -1395,7 +1690,7 @@ litehtml::position litehtml::render_item::get_placement() const
         pos.y += view_port.top();
         return pos;
     }
-    auto cur_el = parent();
+    auto* cur_el = parent_ptr();
     while(cur_el)
     {
         auto p  = cur_el->calc_placement();
@@ -1411,7 +1706,7 @@ litehtml::position litehtml::render_item::get_placement() const
             return pos;
         }
 
-        cur_el = cur_el->parent();
+        cur_el = cur_el->parent_ptr();
     }
     return pos;
 }
@@ -1461,7 +1756,7 @@ litehtml::containing_block_context litehtml::render_item::calculate_containing_b
     // We have to use aut value for display_table_cell also.
     if(src_el()->css().get_display() != display_table_cell)
     {
-        auto par = parent();
+        auto* par = parent_ptr();
         if((cb_context.size_mode & containing_block_context::size_mode_exact_width) != 0)
         {
             ret.width.value = cb_context.width;
@@ -1565,7 +1860,7 @@ litehtml::containing_block_context litehtml::render_item::calculate_containing_b
     // width. So skip the width clamp on that exact-width pass.
     if((cb_context.size_mode & containing_block_context::size_mode_exact_width) != 0)
     {
-        auto par = parent();
+        auto* par = parent_ptr();
         if(par && (par->css().get_display() == display_flex || par->css().get_display() == display_inline_flex) &&
            (par->css().get_flex_direction() == flex_direction_row ||
             par->css().get_flex_direction() == flex_direction_row_reverse))
@@ -1583,14 +1878,14 @@ std::tuple<litehtml::pixel_t, litehtml::pixel_t> litehtml::render_item::element_
 {
     pixel_t offset_x = 0_px;
     pixel_t offset_y = 0_px;
-    auto    cur_el   = el->parent();
+    auto*   cur_el   = el->parent_ptr();
     auto    this_el  = el->css().get_position() != element_position_fixed ? shared_from_this()
                                                                           : src_el()->get_document()->root_render();
-    while(cur_el && cur_el != this_el)
+    while(cur_el && cur_el != this_el.get())
     {
         offset_x += cur_el->m_pos.x;
         offset_y += cur_el->m_pos.y;
-        cur_el    = cur_el->parent();
+        cur_el    = cur_el->parent_ptr();
     }
 
     if(el->css().get_position() == element_position_fixed || (is_root() && !src_el()->is_positioned()))
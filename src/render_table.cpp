@@ -447,7 +447,7 @@ std::shared_ptr<litehtml::render_item> litehtml::render_item_table::init()
 void litehtml::render_item_table::draw_children(uint_ptr hdc, pixel_t x, pixel_t y, const position* clip,
                                                 draw_flag flag, int zindex)
 {
-    if(!m_grid)
+    if(!m_grid || src_el()->get_document()->is_layer_hidden(this))
     {
         return;
     }
@@ -0,0 +1,131 @@
+#include "html.h"
+#include "snapshot.h"
+
+namespace litehtml
+{
+    void snapshot_writer::write_size(size_t val)
+    {
+        while(val >= 0x80)
+        {
+            m_out += static_cast<char>((val & 0x7F) | 0x80);
+            val >>= 7;
+        }
+        m_out += static_cast<char>(val);
+    }
+
+    void snapshot_writer::write_block(const std::string& bytes)
+    {
+        auto ins = m_blocks.emplace(bytes, m_blocks.size() + 1);
+        write_size(ins.first->second);
+        if(ins.second)
+        {
+            write(bytes);
+        }
+    }
+
+    void snapshot_writer::write(const std::string& str)
+    {
+        write_size(str.size());
+        m_out += str;
+    }
+
+    void snapshot_writer::write(const css_length& len)
+    {
+        write(len.is_predefined());
+        if(len.is_predefined())
+        {
+            write(len.predef());
+        } else
+        {
+            write(len.val());
+        }
+        write(len.units());
+    }
+
+    void snapshot_writer::write(pixel_t val)
+    {
+        write(val.value());
+    }
+
+    bool snapshot_reader::read_size(size_t& val)
+    {
+        val = 0;
+        for(int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t b = 0;
+            if(!read_byte(b))
+            {
+                return false;
+            }
+            val |= static_cast<size_t>(b & 0x7F) << shift;
+            if(!(b & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool snapshot_reader::read_block(snapshot_reader& block)
+    {
+        size_t idx = 0;
+        if(!read_size(idx) || idx == 0 || idx > m_blocks.size() + 1)
+        {
+            return false;
+        }
+        if(idx == m_blocks.size() + 1)
+        {
+            size_t len = 0;
+            if(!read_size(len) || len > remaining())
+            {
+                return false;
+            }
+            m_blocks.emplace_back(m_pos, len);
+            m_pos += len;
+        }
+        block.m_pos = m_blocks[idx - 1].first;
+        block.m_end = block.m_pos + m_blocks[idx - 1].second;
+        return true;
+    }
+
+    bool snapshot_reader::read(std::string& str)
+    {
+        size_t len = 0;
+        if(!read_size(len) || len > remaining())
+        {
+            return false;
+        }
+        str.assign(m_pos, len);
+        m_pos += len;
+        return true;
+    }
+
+    bool snapshot_reader::read(css_length& len)
+    {
+        bool      is_predefined = false;
+        int       predef        = 0;
+        float     val           = 0;
+        css_units units         = css_units_none;
+        if(!read(is_predefined) || (is_predefined ? !read(predef) : !read(val)) || !read(units))
+        {
+            return false;
+        }
+        len.set_value(val, units);
+        if(is_predefined)
+        {
+            len.predef(predef);
+        }
+        return true;
+    }
+
+    bool snapshot_reader::read(pixel_t& val)
+    {
+        float value = 0;
+        if(!read(value))
+        {
+            return false;
+        }
+        val = pixel_t(value);
+        return true;
+    }
+} // namespace litehtml
@@ -13,7 +13,7 @@ static std::mutex mutex;
 namespace litehtml
 {
 
-    static std::map<std::string, string_id> map;
+    static std::map<std::string, string_id, std::less<>> map;
     static std::vector<std::string>         array;
 
     static int init()
@@ -48,6 +48,13 @@ namespace litehtml
         return map[str] = static_cast<string_id>(array.size() - 1);
     }
 
+    string_id find_id(const char* str)
+    {
+        lock_guard;
+        auto it = map.find(str);
+        return it != map.end() ? it->second : empty_id;
+    }
+
     const std::string& _s(string_id id)
     {
         lock_guard;
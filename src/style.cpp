@@ -1836,6 +1836,20 @@ namespace litehtml
         }
     }
 
+    const property_value style_index::m_not_found;
+
+    style_index::style_index(const style& st) :
+        m_style(st)
+    {
+        for(const auto& prop : st.m_properties)
+        {
+            if(prop.first >= first_property && prop.first <= last_property)
+            {
+                m_properties[prop.first - first_property] = &prop.second;
+            }
+        }
+    }
+
     const property_value& style::get_property(string_id name) const
     {
         auto it = m_properties.find(name);
@@ -1931,16 +1945,18 @@ namespace litehtml
 
     void style::subst_vars(const html_tag* el)
     {
+        document* doc = el->document_ptr();
         for(auto& prop : m_properties)
         {
             if(prop.second.m_has_var)
             {
-                auto& value = prop.second.get<css_token_vector>();
+                auto value = prop.second.get<css_token_vector>(); // copy is intentional, prop is replaced below
                 subst_vars_(prop.first, value, el);
                 // re-adding the same property
                 // if it is a custom property it will be re-added as a css_token_vector
                 // if it is a standard css property it will be parsed and properly added as typed property
-                add_property(prop.first, value, "", prop.second.m_important, el->get_document()->container());
+                // The parsed value is shared by all elements getting the same substituted value.
+                combine(doc->parse_substituted_property(prop.first, value, prop.second.m_important));
             }
         }
     }
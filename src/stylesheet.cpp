@@ -3,6 +3,7 @@
 #include "css_parser.h"
 #include "document.h"
 #include "document_container.h"
+#include <unordered_map>
 
 namespace litehtml
 {
@@ -135,7 +136,7 @@ namespace litehtml
     void css::parse_css_stylesheet(const Input& input, const std::string& baseurl, const std::shared_ptr<document>& doc,
                                    const media_query_list_list::ptr& media, bool top_level)
     {
-        if(doc && media)
+        if(doc && media && !m_shared)
         {
             doc->add_media_list(media);
         }
@@ -260,6 +261,7 @@ namespace litehtml
             css_parse_error("invalid @import rule");
             return;
         }
+        m_has_imports                 = true;
         document_container* container = doc->container();
         std::string         css_text;
         std::string         css_baseurl = baseurl;
@@ -304,6 +306,40 @@ namespace litehtml
         return true;
     }
 
+    void css::add_selectors(const css& sheet, const media_query_list_list::ptr& media, document* doc)
+    {
+        if(doc && media)
+        {
+            doc->add_media_list(media);
+        }
+
+        // The selectors of the same @media block share the media list, so do the copies
+        std::unordered_map<const media_query_list_list*, media_query_list_list::ptr> media_lists;
+        m_selectors.reserve(m_selectors.size() + sheet.m_selectors.size());
+        for(const auto& sel : sheet.m_selectors)
+        {
+            auto copy = std::make_shared<css_selector>(*sel);
+            if(sel->m_media_query)
+            {
+                auto& list = media_lists[sel->m_media_query.get()];
+                if(!list)
+                {
+                    list = std::make_shared<media_query_list_list>(media ? *media : media_query_list_list());
+                    list->add(*sel->m_media_query);
+                    if(doc)
+                    {
+                        doc->add_media_list(list);
+                    }
+                }
+                copy->m_media_query = list;
+            } else
+            {
+                copy->m_media_query = media;
+            }
+            add_selector(copy);
+        }
+    }
+
     void css::sort_selectors()
     {
         std::sort(m_selectors.begin(), m_selectors.end(),
@@ -0,0 +1,138 @@
+#include "html.h"
+#include "stylesheet_cache.h"
+#include "document.h"
+
+#ifndef LITEHTML_NO_THREADS
+#define lock_guard std::lock_guard<std::mutex> lock(m_mutex)
+#else
+#define lock_guard
+#endif
+
+namespace litehtml
+{
+    stylesheet_cache& stylesheet_cache::instance()
+    {
+        static stylesheet_cache cache;
+        return cache;
+    }
+
+    void stylesheet_cache::set_capacity(size_t count)
+    {
+        lock_guard;
+        m_capacity = count;
+        while(m_entries.size() > m_capacity)
+        {
+            remove(std::prev(m_entries.end()));
+        }
+    }
+
+    size_t stylesheet_cache::capacity()
+    {
+        lock_guard;
+        return m_capacity;
+    }
+
+    void stylesheet_cache::clear()
+    {
+        lock_guard;
+        m_entries.clear();
+        m_index.clear();
+    }
+
+    stylesheet_cache::statistics stylesheet_cache::get_statistics()
+    {
+        lock_guard;
+        statistics ret = m_stats;
+        ret.entries    = m_entries.size();
+        return ret;
+    }
+
+    void stylesheet_cache::parse_css_stylesheet(css& target, const std::string& text, const std::string& baseurl,
+                                                const std::shared_ptr<document>& doc,
+                                                const media_query_list_list::ptr& media)
+    {
+        if(capacity() == 0 || !doc)
+        {
+            target.parse_css_stylesheet(text, baseurl, doc, media);
+            return;
+        }
+
+        size_t        hash  = std::hash<std::string>{}(text);
+        document_mode mode  = doc->mode();
+        auto          sheet = find(hash, text, baseurl, mode);
+        if(!sheet)
+        {
+            // Parse without lock, the same stylesheet can be parsed by several threads at once, the last one is kept
+            auto parsed = std::make_shared<css>(true);
+            parsed->parse_css_stylesheet(text, baseurl, doc);
+            if(!parsed->has_imports())
+            {
+                insert(hash, text, baseurl, mode, parsed);
+            }
+            sheet = parsed;
+        }
+        target.add_selectors(*sheet, media, doc.get());
+    }
+
+    std::shared_ptr<const css> stylesheet_cache::find(size_t hash, const std::string& text, const std::string& baseurl,
+                                                      document_mode mode)
+    {
+        lock_guard;
+        auto range = m_index.equal_range(hash);
+        for(auto it = range.first; it != range.second; ++it)
+        {
+            auto entry = it->second;
+            if(entry->mode == mode && entry->baseurl == baseurl && entry->text == text)
+            {
+                m_entries.splice(m_entries.begin(), m_entries, entry);
+                m_stats.hits++;
+                return entry->sheet;
+            }
+        }
+        m_stats.misses++;
+        return nullptr;
+    }
+
+    void stylesheet_cache::insert(size_t hash, const std::string& text, const std::string& baseurl, document_mode mode,
+                                  const std::shared_ptr<const css>& sheet)
+    {
+        lock_guard;
+        if(m_capacity == 0)
+        {
+            return;
+        }
+        auto range = m_index.equal_range(hash);
+        for(auto it = range.first; it != range.second; ++it)
+        {
+            auto entry = it->second;
+            if(entry->mode == mode && entry->baseurl == baseurl && entry->text == text)
+            {
+                // Parsed by another thread meanwhile
+                entry->sheet = sheet;
+                m_entries.splice(m_entries.begin(), m_entries, entry);
+                return;
+            }
+        }
+
+        m_entries.push_front({hash, text, baseurl, mode, sheet});
+        m_index.emplace(hash, m_entries.begin());
+        while(m_entries.size() > m_capacity)
+        {
+            remove(std::prev(m_entries.end()));
+        }
+    }
+
+    void stylesheet_cache::remove(entries_list::iterator iter)
+    {
+        auto range = m_index.equal_range(iter->hash);
+        for(auto it = range.first; it != range.second; ++it)
+        {
+            if(it->second == iter)
+            {
+                m_index.erase(it);
+                break;
+            }
+        }
+        m_entries.erase(iter);
+    }
+} // namespace litehtml
@@ -7,8 +7,8 @@ void litehtml::table_grid::add_cell(const std::shared_ptr<render_item>& el)
 {
     table_cell cell;
     cell.el      = el;
-    cell.colspan = atoi(el->src_el()->get_attr("colspan", "1"));
-    cell.rowspan = atoi(el->src_el()->get_attr("rowspan", "1"));
+    cell.colspan = atoi(el->src_el()->get_attr(_colspan_, "1"));
+    cell.rowspan = atoi(el->src_el()->get_attr(_rowspan_, "1"));
     cell.borders = el->get_borders();
 
     while(is_rowspanned(static_cast<int>(m_cells.size()) - 1, static_cast<int>(m_cells.back().size())))
@@ -0,0 +1,188 @@
+#include "layer_compositor.h"
+#include <algorithm>
+#include <cmath>
+
+/// @brief Synchronize the layers with the document.
+///
+/// The surfaces of the layers having the same identifier and content size are kept, the scroll position and
+/// placement are updated.
+/// @param layers layers returned by litehtml::document::get_layers
+void litebrowser::layer_compositor::update(const litehtml::layer_info::vector& layers)
+{
+    std::vector<layer> new_layers;
+    new_layers.reserve(layers.size());
+
+    for(const auto& info : layers)
+    {
+        // The document layer is kept by draw_buffer
+        if(info.type == litehtml::layer_type_document)
+        {
+            continue;
+        }
+
+        layer item;
+        item.info = info;
+
+        auto old = std::find_if(m_layers.begin(), m_layers.end(),
+                                [&info](const layer& l) { return l.surface && l.info.id == info.id; });
+        if(old != m_layers.end() && old->info.content_size.width == info.content_size.width &&
+           old->info.content_size.height == info.content_size.height && old->info.box.width == info.box.width &&
+           old->info.box.height == info.box.height)
+        {
+            item.surface  = old->surface;
+            item.width    = old->width;
+            item.height   = old->height;
+            item.origin_x = old->origin_x;
+            item.origin_y = old->origin_y;
+            // Fixed layer surface is placed by the box, so it has to be rasterized again if the box was moved
+            item.valid    = old->valid && (info.type != litehtml::layer_type_fixed || old->info.box == info.box);
+            old->surface  = nullptr;
+        }
+        new_layers.push_back(item);
+    }
+
+    clear();
+    m_layers = std::move(new_layers);
+}
+
+/// @brief Composite layers over the target
+///
+/// The target context must be in the scaled coordinates, like the draw_buffer surface.
+///
+/// @param cr the target cairo context
+/// @param cb_draw the callback for drawing the layer
+/// @param left horizontal scroll position of the page
+/// @param top vertical scroll position of the page
+void litebrowser::layer_compositor::composite(cairo_t* cr, const draw_layer_function_t& cb_draw, int left, int top)
+{
+    for(auto& item : m_layers)
+    {
+        const auto& info = item.info;
+
+        // The partially cached scroll layer is valid for the cached scroll position only
+        if(item.valid && info.type == litehtml::layer_type_scroll &&
+           (item.width < (int) std::ceil(info.content_size.width.value()) ||
+            item.height < (int) std::ceil(info.content_size.height.value())))
+        {
+            if(item.origin_x != (int) info.scroll_left.value() || item.origin_y != (int) info.scroll_top.value())
+            {
+                item.valid = false;
+            }
+        }
+
+        if(!item.valid)
+        {
+            rasterize(item, cb_draw);
+        }
+        if(!item.surface)
+        {
+            continue;
+        }
+
+        double dest_x = 0;
+        double dest_y = 0;
+
+        cairo_save(cr);
+        if(info.type == litehtml::layer_type_fixed)
+        {
+            // Fixed layers are placed in the viewport coordinates
+            dest_x = item.origin_x;
+            dest_y = item.origin_y;
+        } else
+        {
+            // Scroll layers are placed in the document and clipped by the scroll box
+            double box_x = info.box.x.value() - left;
+            double box_y = info.box.y.value() - top;
+            cairo_rectangle(cr, box_x * m_scale_factor, box_y * m_scale_factor, info.box.width.value() * m_scale_factor,
+                            info.box.height.value() * m_scale_factor);
+            cairo_clip(cr);
+            dest_x = box_x - info.scroll_left.value() + item.origin_x;
+            dest_y = box_y - info.scroll_top.value() + item.origin_y;
+        }
+        cairo_set_source_surface(cr, item.surface, std::round(dest_x * m_scale_factor),
+                                 std::round(dest_y * m_scale_factor));
+        cairo_paint(cr);
+        cairo_restore(cr);
+    }
+}
+
+/// @brief Release all layers
+void litebrowser::layer_compositor::clear()
+{
+    for(auto& item : m_layers)
+    {
+        if(item.surface)
+        {
+            cairo_surface_destroy(item.surface);
+            item.surface = nullptr;
+        }
+    }
+    m_layers.clear();
+}
+
+void litebrowser::layer_compositor::rasterize(layer& item, const draw_layer_function_t& cb_draw)
+{
+    const auto& info = item.info;
+
+    // Position of the surface in the layer coordinates: fixed layers are drawn relative to the viewport, scroll
+    // layers are drawn relative to the scrolled content.
+    int origin_x = 0;
+    int origin_y = 0;
+    int width    = 0;
+    int height   = 0;
+    if(info.type == litehtml::layer_type_fixed)
+    {
+        origin_x = (int) std::floor(info.box.left().value());
+        origin_y = (int) std::floor(info.box.top().value());
+        width    = (int) std::ceil(info.box.right().value()) - origin_x;
+        height   = (int) std::ceil(info.box.bottom().value()) - origin_y;
+    } else
+    {
+        width  = (int) std::ceil(info.content_size.width.value());
+        height = (int) std::ceil(info.content_size.height.value());
+        if(width > m_max_surface_size || height > m_max_surface_size)
+        {
+            // Cache the visible part only
+            origin_x = (int) info.scroll_left.value();
+            origin_y = (int) info.scroll_top.value();
+            width    = (int) std::ceil(info.box.width.value());
+            height   = (int) std::ceil(info.box.height.value());
+        }
+    }
+
+    if(!item.surface || item.width != width || item.height != height)
+    {
+        if(item.surface)
+        {
+            cairo_surface_destroy(item.surface);
+            item.surface = nullptr;
+        }
+        item.width  = width;
+        item.height = height;
+        if(width <= 0 || height <= 0)
+        {
+            return;
+        }
+        item.surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, (int) std::ceil((double) width * m_scale_factor),
+                                                  (int) std::ceil((double) height * m_scale_factor));
+    }
+    item.origin_x = origin_x;
+    item.origin_y = origin_y;
+
+    cairo_t* cr = cairo_create(item.surface);
+
+    // Clear the surface, layers are transparent
+    cairo_set_operator(cr, CAIRO_OPERATOR_CLEAR);
+    cairo_paint(cr);
+    cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
+
+    // Apply scale for drawing
+    cairo_scale(cr, m_scale_factor, m_scale_factor);
+
+    litehtml::position clip{(litehtml::pixel_t) 0, (litehtml::pixel_t) 0, (litehtml::pixel_t) width,
+                            (litehtml::pixel_t) height};
+    cb_draw(cr, -origin_x, -origin_y, &clip, info.id);
+
+    cairo_destroy(cr);
+    item.valid = true;
+}
@@ -0,0 +1,109 @@
+#ifndef LITEBROWSER_LAYER_COMPOSITOR_H
+#define LITEBROWSER_LAYER_COMPOSITOR_H
+
+#include <cairo.h>
+#include <functional>
+#include <vector>
+#include "litehtml/types.h"
+
+namespace litebrowser
+{
+    /// @brief Layer Compositor Class
+    ///
+    /// This class keeps the cached raster surfaces of the document layers (fixed elements and scroll boxes, see
+    /// litehtml::document::get_layers) and composites them over the draw_buffer. The document layer is kept by the
+    /// draw_buffer itself, so it must be drawn with litehtml::document::draw_layer(..., 0) in this mode.
+    ///
+    /// The layer surface is rasterized only when the layer is invalidated or its size is changed. Scrolling of the
+    /// page or of the scroll box just blits the cached surfaces with the new offsets.
+    class layer_compositor
+    {
+      public:
+        using draw_layer_function_t = std::function<void(cairo_t* cr, int x, int y, const litehtml::position* clip,
+                                                         litehtml::uint_ptr layer_id)>;
+
+      private:
+        struct layer
+        {
+            litehtml::layer_info info;
+            cairo_surface_t*     surface  = nullptr;
+            int                  width    = 0; // surface width (not scaled)
+            int                  height   = 0; // surface height (not scaled)
+            int                  origin_x = 0; // position of the surface in the layer content
+            int                  origin_y = 0;
+            bool                 valid    = false;
+        };
+
+        std::vector<layer> m_layers;
+        double             m_scale_factor     = 1;
+        int                m_max_surface_size = 4096;
+
+      public:
+        ~layer_compositor()
+        {
+            clear();
+        }
+
+        [[nodiscard]]
+        double get_scale_factor() const
+        {
+            return m_scale_factor;
+        }
+
+        /// @brief Set scale factor for the layer surfaces
+        /// @param scale the scale factor to be applied
+        void set_scale_factor(double scale)
+        {
+            if(m_scale_factor != scale)
+            {
+                m_scale_factor = scale;
+                clear();
+            }
+        }
+
+        /// @brief Set the maximum size of the layer surface.
+        ///
+        /// The scroll layer with larger content caches the visible part only, which is rasterized again when the box
+        /// is scrolled.
+        /// @param size maximum width and height of the surface (not scaled)
+        void set_max_surface_size(int size)
+        {
+            m_max_surface_size = size;
+        }
+
+        /// @brief Synchronize the layers with the document.
+        ///
+        /// The surfaces of the layers having the same identifier and content size are kept, the scroll position and
+        /// placement are updated.
+        /// @param layers layers returned by litehtml::document::get_layers
+        void update(const litehtml::layer_info::vector& layers);
+
+        /// @brief Mark all surfaces to be rasterized again on the next composite
+        void invalidate()
+        {
+            for(auto& item : m_layers)
+            {
+                item.valid = false;
+            }
+        }
+
+        /// @brief Composite layers over the target
+        ///
+        /// The target context must be in the scaled coordinates, like the draw_buffer surface.
+        ///
+        /// @param cr the target cairo context
+        /// @param cb_draw the callback for drawing the layer
+        /// @param left horizontal scroll position of the page
+        /// @param top vertical scroll position of the page
+        void composite(cairo_t* cr, const draw_layer_function_t& cb_draw, int left, int top);
+
+        /// @brief Release all layers
+        void clear();
+
+      private:
+        void rasterize(layer& item, const draw_layer_function_t& cb_draw);
+    };
+
+} // namespace litebrowser
+
+#endif
@@ -1,4 +1,5 @@
 #include "html_widget.h"
+#include <algorithm>
 
 using litehtml::operator""_px;
 
@@ -11,6 +12,7 @@ html_widget::html_widget()
     m_notifier->connect_render(sigc::mem_fun(*this, &html_widget::render));
     m_notifier->connect_update_state([this]() { m_sig_update_state.emit(get_state()); });
     m_notifier->connect_on_page_loaded(sigc::mem_fun(*this, &html_widget::on_page_loaded));
+    m_notifier->connect_on_page_partially_loaded(sigc::mem_fun(*this, &html_widget::on_page_partially_loaded));
     m_notifier->connect_on_set_caption(sigc::mem_fun(*this, &html_widget::set_caption));
 
     set_focusable(true);
@@ -126,6 +128,20 @@ void html_widget::snapshot_vfunc(const Glib::RefPtr<Gtk::Snapshot>& snapshot)
             cr->scale(1.0 / m_draw_buffer.get_scale_factor(), 1.0 / m_draw_buffer.get_scale_factor());
             cairo_set_source_surface(cr->cobj(), m_draw_buffer.get_cairo_surface(), 0, 0);
             cr->paint();
+
+            auto page = current_page();
+            if(use_layers(page))
+            {
+                cr->scale(m_draw_buffer.get_scale_factor(), m_draw_buffer.get_scale_factor());
+                m_layers.set_scale_factor(m_draw_buffer.get_scale_factor());
+                m_layers.update(page->get_layers());
+                m_layers.composite(cr->cobj(), get_draw_layer_function(page), m_draw_buffer.get_left(),
+                                   m_draw_buffer.get_top());
+            }
+            if(page)
+            {
+                page->next_frame();
+            }
         }
     }
 
@@ -198,6 +214,7 @@ void html_widget::open_page(const std::string& url, const std::string& fragment)
             m_current_page->stop_loading();
         }
         m_next_page = std::make_shared<litebrowser::web_page>(this, m_notifier, 10);
+        m_next_page->set_use_layers(m_use_layers);
         m_next_page->open(url, fragment);
     }
     m_sig_set_address.emit(url);
@@ -212,6 +229,7 @@ void html_widget::scroll_to(int x, int y)
 
 void html_widget::on_redraw()
 {
+    m_layers.invalidate();
     m_draw_buffer.redraw(get_draw_function(current_page()));
     queue_draw();
 }
@@ -243,6 +261,7 @@ void html_widget::on_button_press_event(int /* n_press */, double x, double y)
                               (int) y, [&](const litehtml::position& box) { update_rect(box, rect, is_first); });
         if(!rect.has_zero_area())
         {
+            m_layers.invalidate();
             m_draw_buffer.redraw_area(get_draw_function(current_page()), rect.get_x(), rect.get_y(), rect.get_width(),
                                       rect.get_height());
             queue_draw();
@@ -261,6 +280,7 @@ void html_widget::on_button_release_event(int /* n_press */, double x, double y)
                             [&](const litehtml::position& box) { update_rect(box, rect, is_first); });
         if(!rect.has_zero_area())
         {
+            m_layers.invalidate();
             m_draw_buffer.redraw_area(get_draw_function(current_page()), rect.get_x(), rect.get_y(), rect.get_width(),
                                       rect.get_height());
             queue_draw();
@@ -314,6 +334,7 @@ void html_widget::on_mouse_move(double x, double y)
                             [&](const litehtml::position& box) { update_rect(box, rect, is_first); });
         if(!rect.has_zero_area())
         {
+            m_layers.invalidate();
             m_draw_buffer.redraw_area(get_draw_function(current_page()), rect.get_x(), rect.get_y(), rect.get_width(),
                                       rect.get_height());
             queue_draw();
@@ -397,6 +418,7 @@ void html_widget::size_allocate_vfunc(int width, int height, int /* baseline */)
             page->media_changed();
             page->render(m_rendered_width);
             update_view_port(page);
+            m_layers.invalidate();
             m_draw_buffer.redraw(get_draw_function(page));
             queue_draw();
         }
@@ -437,7 +459,7 @@ void html_widget::on_vadjustment_changed()
 {
     auto page = current_page();
     m_draw_buffer.on_scroll(get_draw_function(page), (int) m_hadjustment->get_value(), (int) m_vadjustment->get_value(),
-                            page ? page->get_fixed_boxes() : litehtml::position::vector{});
+                            page && !page->use_layers() ? page->get_fixed_boxes() : litehtml::position::vector{});
 
     if(m_do_force_redraw_on_adjustment)
     {
@@ -452,7 +474,7 @@ void html_widget::on_hadjustment_changed()
 {
     auto page = current_page();
     m_draw_buffer.on_scroll(get_draw_function(page), (int) m_hadjustment->get_value(), (int) m_vadjustment->get_value(),
-                            page ? page->get_fixed_boxes() : litehtml::position::vector{});
+                            page && !page->use_layers() ? page->get_fixed_boxes() : litehtml::position::vector{});
 
     if(m_do_force_redraw_on_adjustment)
     {
@@ -490,8 +512,22 @@ bool html_widget::on_scroll(double dx, double dy)
                 {
                     dy_used = true;
                 }
-                m_draw_buffer.redraw_area(get_draw_function(current_page()), val.scroll_box.left(),
-                                          val.scroll_box.top(), val.scroll_box.width, val.scroll_box.height);
+                if(use_layers(page))
+                {
+                    // The scrolled content of the layer is just composited with the new offset
+                    auto layers   = page->get_layers();
+                    bool is_layer = std::any_of(layers.begin(), layers.end(), [&val](const litehtml::layer_info& l) {
+                        return l.type == litehtml::layer_type_scroll && l.box == val.scroll_box;
+                    });
+                    if(is_layer)
+                    {
+                        continue;
+                    }
+                    // The nested scroll box is drawn into the cached surface of its layer
+                    m_layers.invalidate();
+                }
+                m_draw_buffer.redraw_area(get_draw_function(page), val.scroll_box.left(), val.scroll_box.top(),
+                                          val.scroll_box.width, val.scroll_box.height);
             }
             queue_draw();
         }
@@ -598,6 +634,7 @@ void html_widget::redraw_boxes(const litehtml::position::vector& boxes)
 
     if(!rect.has_zero_area())
     {
+        m_layers.invalidate();
         m_draw_buffer.redraw_area(get_draw_function(current_page()), rect.get_x(), rect.get_y(), rect.get_width(),
                                   rect.get_height());
         queue_draw();
@@ -612,23 +649,50 @@ int html_widget::get_render_width()
 void html_widget::on_page_loaded(uint64_t web_page_id)
 {
     std::string url;
+    bool        first_paint;
     {
         std::lock_guard<std::mutex> lock(m_page_mutex);
         if(m_next_page->id() != web_page_id)
         {
             return;
         }
+        // The page could be already shown by on_page_partially_loaded
+        first_paint    = m_current_page != m_next_page;
         m_current_page = m_next_page;
         m_next_page    = nullptr;
         url            = m_current_page->url();
         update_view_port(m_current_page);
     }
-    scroll_to(0, 0);
+    if(first_paint)
+    {
+        scroll_to(0, 0);
+    }
     on_redraw();
     m_sig_set_address.emit(url);
     m_sig_update_state.emit(get_state());
 }
 
+void html_widget::on_page_partially_loaded(uint64_t web_page_id)
+{
+    bool first_paint;
+    {
+        std::lock_guard<std::mutex> lock(m_page_mutex);
+        if(!m_next_page || m_next_page->id() != web_page_id)
+        {
+            return;
+        }
+        // The page is shown, but it stays the next page until it is loaded completely
+        first_paint    = m_current_page != m_next_page;
+        m_current_page = m_next_page;
+        update_view_port(m_current_page);
+    }
+    if(first_paint)
+    {
+        scroll_to(0, 0);
+    }
+    on_redraw();
+}
+
 void html_widget::show_fragment(const std::string& fragment)
 {
     std::shared_ptr<litebrowser::web_page> page = current_page();
@@ -696,6 +760,7 @@ void html_widget::render()
     {
         page->render(m_draw_buffer.get_width());
         update_view_port(page);
+        m_layers.invalidate();
         m_draw_buffer.redraw(get_draw_function(page));
         queue_draw();
     }
@@ -5,6 +5,7 @@
 #include "web_page.h"
 #include "web_history.h"
 #include "../draw_buffer/draw_buffer.h"
+#include "../draw_buffer/layer_compositor.h"
 #include <queue>
 
 enum page_state
@@ -32,6 +33,7 @@ class html_widget_notifier : public litebrowser::browser_notify_interface
         func_type_render,
         func_type_update_state,
         func_type_on_page_loaded,
+        func_type_on_page_partially_loaded,
         func_type_on_set_caption
     };
     struct queue_item
@@ -46,6 +48,7 @@ class html_widget_notifier : public litebrowser::browser_notify_interface
     render_func         m_render_func;
     update_state_func   m_update_state_func;
     on_page_loaded_func m_on_page_loaded_func;
+    on_page_loaded_func m_on_page_partially_loaded_func;
     on_set_caption_func m_on_set_caption_func;
 
     std::mutex             m_lock;
@@ -84,6 +87,11 @@ class html_widget_notifier : public litebrowser::browser_notify_interface
         m_on_page_loaded_func = _on_page_loaded_func;
     }
 
+    void connect_on_page_partially_loaded(on_page_loaded_func _on_page_partially_loaded_func)
+    {
+        m_on_page_partially_loaded_func = _on_page_partially_loaded_func;
+    }
+
     void connect_on_set_caption(on_set_caption_func _on_set_caption_func)
     {
         m_on_set_caption_func = _on_set_caption_func;
@@ -126,6 +134,15 @@ class html_widget_notifier : public litebrowser::browser_notify_interface
         m_dispatcher.emit();
     }
 
+    void on_page_partially_loaded(uint64_t web_page_id) override
+    {
+        {
+            std::lock_guard lock(m_lock);
+            m_queue.push(queue_item{func_type_on_page_partially_loaded, web_page_id, {}});
+        }
+        m_dispatcher.emit();
+    }
+
     void on_set_caption(const std::string& caption) override
     {
         {
@@ -185,6 +202,12 @@ class html_widget_notifier : public litebrowser::browser_notify_interface
                         m_on_page_loaded_func(item.param);
                     }
                     break;
+                case func_type_on_page_partially_loaded:
+                    if(m_on_page_partially_loaded_func)
+                    {
+                        m_on_page_partially_loaded_func(item.param);
+                    }
+                    break;
                 case func_type_on_set_caption:
                     if(m_on_set_caption_func)
                     {
@@ -221,13 +244,16 @@ class html_widget : public Gtk::Widget, public litebrowser::html_host_interface
 
     sigc::connection m_scrollbar_timer;
 
-    litebrowser::draw_buffer m_draw_buffer;
+    litebrowser::draw_buffer      m_draw_buffer;
+    litebrowser::layer_compositor m_layers;
+    bool                          m_use_layers = false;
 
   public:
     explicit html_widget();
     ~html_widget() override;
 
     void     on_page_loaded(uint64_t web_page_id);
+    void     on_page_partially_loaded(uint64_t web_page_id);
     void     render();
     void     go_forward();
     void     go_back();
@@ -235,6 +261,14 @@ class html_widget : public Gtk::Widget, public litebrowser::html_host_interface
     void     stop_download();
     void     reload();
 
+    /// @brief Draw fixed elements and scroll boxes as the separate cached layers.
+    ///
+    /// Applied to the pages opened after the call.
+    void set_use_layers(bool use_layers)
+    {
+        m_use_layers = use_layers;
+    }
+
     std::string get_html_source();
     void        show_fragment(const std::string& fragment);
     bool        on_close();
@@ -302,10 +336,32 @@ class html_widget : public Gtk::Widget, public litebrowser::html_host_interface
         return [page](cairo_t* cr, int x, int y, const litehtml::position* clip) {
             if(page)
             {
-                page->draw((litehtml::uint_ptr) cr, x, y, clip);
+                if(page->use_layers())
+                {
+                    // Fixed elements and scroll boxes are composited by m_layers
+                    page->draw_layer((litehtml::uint_ptr) cr, x, y, clip, 0);
+                } else
+                {
+                    page->draw((litehtml::uint_ptr) cr, x, y, clip);
+                }
             }
         };
     }
+    litebrowser::layer_compositor::draw_layer_function_t
+    get_draw_layer_function(const std::shared_ptr<litebrowser::web_page>& page)
+    {
+        return [page](cairo_t* cr, int x, int y, const litehtml::position* clip, litehtml::uint_ptr layer_id) {
+            if(page)
+            {
+                page->draw_layer((litehtml::uint_ptr) cr, x, y, clip, layer_id);
+            }
+        };
+    }
+    [[nodiscard]]
+    static bool use_layers(const std::shared_ptr<litebrowser::web_page>& page)
+    {
+        return page && page->use_layers();
+    }
 
   public:
     // Signals types
@@ -33,6 +33,8 @@ namespace litebrowser
         virtual void update_state()                                  = 0;
         virtual void on_set_caption(const std::string& caption_text) = 0;
         virtual void on_page_loaded(uint64_t web_page_id)            = 0;
+        // The partial document is ready to be shown while the page is downloading
+        virtual void on_page_partially_loaded(uint64_t web_page_id)  = 0;
     };
 
 } // namespace litebrowser
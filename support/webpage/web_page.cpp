@@ -39,15 +39,19 @@ void litebrowser::web_page::open(const std::string& url, const std::string& frag
     }
     m_base_url = m_url;
     m_fragment = fragment;
+    {
+        std::lock_guard<std::mutex> css_lock(m_imported_css_mutex);
+        m_imported_css.clear();
+    }
 
-    auto data       = std::make_shared<text_file>();
-    auto cb_on_data = [data](void* in_data, size_t len, size_t /*downloaded*/, size_t /*total*/) {
-        data->on_data(in_data, len, 0, 0);
+    auto builder     = std::make_shared<litehtml::document_builder>(this);
+    auto shared_this = shared_from_this();
+    auto cb_on_data  = [shared_this, builder](void* in_data, size_t len, size_t /*downloaded*/, size_t /*total*/) {
+        shared_this->on_page_data(builder, in_data, len);
     };
-    auto shared_this  = shared_from_this();
-    auto cb_on_finish = [shared_this, data](u_int32_t http_status, u_int32_t err_code, const std::string& err_text,
-                                            const std::string& url) {
-        shared_this->on_page_downloaded(data, http_status, err_code, err_text, url);
+    auto cb_on_finish = [shared_this, builder](u_int32_t http_status, u_int32_t err_code, const std::string& err_text,
+                                               const std::string& url) {
+        shared_this->on_page_downloaded(builder, http_status, err_code, err_text, url);
     };
     http_request(m_url, cb_on_data, cb_on_finish);
 }
@@ -82,6 +86,20 @@ void litebrowser::web_page::import_css(std::string& text, const std::string& url
     std::string css_url;
     make_url(url.c_str(), baseurl.c_str(), css_url);
 
+    {
+        std::lock_guard<std::mutex> css_lock(m_imported_css_mutex);
+        auto                        iter = m_imported_css.find(css_url);
+        if(iter != m_imported_css.end())
+        {
+            text = iter->second;
+            if(!text.empty())
+            {
+                baseurl = css_url;
+            }
+            return;
+        }
+    }
+
     auto data       = std::make_shared<text_file>();
     auto cb_on_data = [data](void* in_data, size_t len, size_t /*downloaded*/, size_t /*total*/) {
         data->on_data(in_data, len, 0, 0);
@@ -97,6 +115,9 @@ void litebrowser::web_page::import_css(std::string& text, const std::string& url
     {
         baseurl = css_url;
     }
+
+    std::lock_guard<std::mutex> css_lock(m_imported_css_mutex);
+    m_imported_css[css_url] = text;
 }
 
 void litebrowser::web_page::set_caption(const char* caption)
@@ -117,7 +138,23 @@ void litebrowser::web_page::set_base_url(const char* base_url)
 
 cairo_surface_t* litebrowser::web_page::get_image(const std::string& url)
 {
-    return m_images.get_image(url);
+    cairo_surface_t* img = m_images.get_image(url);
+    if(!img && m_images.reserve(url))
+    {
+        // The image was released to keep the cache budget, the layout already has its size
+        download_image(url, true);
+    }
+    return img;
+}
+
+cairo_surface_t* litebrowser::web_page::get_scaled_image(const std::string& url, int width, int height)
+{
+    cairo_surface_t* img = m_images.get_scaled_image(url, width, height, scale_surface);
+    if(!img && m_images.reserve(url))
+    {
+        download_image(url, true);
+    }
+    return img;
 }
 
 void litebrowser::web_page::show_fragment(const std::string& fragment)
@@ -206,30 +243,67 @@ void litebrowser::web_page::on_lbutton_up(int x, int y, int client_x, int client
     }
 }
 
-void litebrowser::web_page::on_page_downloaded(std::shared_ptr<text_file> data, u_int32_t /*http_status*/,
-                                               u_int32_t err_code, const std::string& err_text, const std::string& url)
+void litebrowser::web_page::on_page_data(const std::shared_ptr<litehtml::document_builder>& builder, void* data,
+                                         size_t len)
+{
+    builder->append((const char*) data, len);
+
+    // The partial document is parsed from the beginning every time, so the next one is created when the received
+    // data is doubled.
+    const size_t first_paint_size = 16 * 1024;
+    if(builder->size() < first_paint_size || builder->size() < builder->partial_size() * 2)
+    {
+        return;
+    }
+    auto doc = builder->create_partial_document();
+    if(!doc)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
+        m_html           = doc;
+        int render_width = m_html_host->get_render_width();
+        m_html->enable_layers(m_use_layers);
+        m_html->render(render_width);
+    }
+    m_notify->on_page_partially_loaded(id());
+}
+
+void litebrowser::web_page::on_page_downloaded(const std::shared_ptr<litehtml::document_builder>& builder,
+                                               u_int32_t /*http_status*/, u_int32_t err_code,
+                                               const std::string& err_text, const std::string& url)
 {
+    litehtml::document::ptr doc;
     if(err_code == 0)
     {
         m_url = url;
-        std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
-        data->set_ready();
-        m_html_source = data->str();
+        {
+            std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
+            m_html_source = builder->source();
+        }
+        doc = builder->finish();
     } else
     {
-        std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
-        std::stringstream                     ss;
-        ss << "<h1>Impossible to load page</h1>" << std::endl;
-        ss << "<p>Error #" << err_code << ": " << err_text << "</p>" << std::endl;
-        m_html_source = ss.str();
+        {
+            std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
+            std::stringstream                     ss;
+            ss << "<h1>Impossible to load page</h1>" << std::endl;
+            ss << "<p>Error #" << err_code << ": " << err_text << "</p>" << std::endl;
+            m_html_source = ss.str();
+        }
+        doc = litehtml::document::createFromString(m_html_source, this);
     }
 
-    m_html = litehtml::document::createFromString(m_html_source, this);
-    if(m_html)
     {
         std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
-        int                                   render_width = m_html_host->get_render_width();
-        m_html->render(render_width);
+        m_html = doc;
+        if(m_html)
+        {
+            int render_width = m_html_host->get_render_width();
+            m_html->enable_layers(m_use_layers);
+            m_html->render(render_width);
+        }
     }
     m_notify->on_page_loaded(id());
 }
@@ -264,20 +338,25 @@ void litebrowser::web_page::load_image(const char* src, const char* baseurl, boo
 
     if(m_images.reserve(url))
     {
-        auto data       = std::make_shared<image_file>(url, redraw_on_ready);
-        auto cb_on_data = [data](void* in_data, size_t len, size_t /*downloaded*/, size_t /*total*/) {
-            data->on_data(in_data, len, 0, 0);
-        };
-        auto shared_this  = shared_from_this();
-        auto cb_on_finish = [shared_this, data](u_int32_t http_status, u_int32_t err_code, const std::string& err_text,
-                                                const std::string& url) {
-            shared_this->on_image_downloaded(data, http_status, err_code, err_text, url);
-        };
-
-        http_request(url, cb_on_data, cb_on_finish);
+        download_image(url, redraw_on_ready);
     }
 }
 
+void litebrowser::web_page::download_image(const std::string& url, bool redraw_on_ready)
+{
+    auto data       = std::make_shared<image_file>(url, redraw_on_ready);
+    auto cb_on_data = [data](void* in_data, size_t len, size_t /*downloaded*/, size_t /*total*/) {
+        data->on_data(in_data, len, 0, 0);
+    };
+    auto shared_this  = shared_from_this();
+    auto cb_on_finish = [shared_this, data](u_int32_t http_status, u_int32_t err_code, const std::string& err_text,
+                                            const std::string& url) {
+        shared_this->on_image_downloaded(data, http_status, err_code, err_text, url);
+    };
+
+    http_request(url, cb_on_data, cb_on_finish);
+}
+
 void litebrowser::web_page::http_request(
     const std::string& url, const std::function<void(void*, size_t, size_t, size_t)>& cb_on_data,
     const std::function<void(u_int32_t, u_int32_t, const std::string&, const std::string&)>& cb_on_finish)
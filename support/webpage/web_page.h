@@ -2,6 +2,8 @@
 #define LITEBROWSER_WEB_PAGE_H
 
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <unistd.h>
 #include <sstream>
 #include <vector>
@@ -89,8 +91,13 @@ namespace litebrowser
         std::string                     m_fragment;
         html_host_interface*            m_html_host;
         cairo_images_cache              m_images;
+        // Imported stylesheets by url. The partial documents and the final one import the same stylesheets, so they
+        // are downloaded once.
+        std::unordered_map<std::string, std::string> m_imported_css;
+        std::mutex                                   m_imported_css_mutex;
         litebrowser::http_requests_pool m_requests_pool;
         std::string                     m_html_source;
+        bool                            m_use_layers = false;
 
         std::shared_ptr<browser_notify_interface> m_notify;
 
@@ -124,6 +131,7 @@ namespace litebrowser
         void             set_caption(const char* caption) override;
         void             set_base_url(const char* base_url) override;
         cairo_surface_t* get_image(const std::string& url) override;
+        cairo_surface_t* get_scaled_image(const std::string& url, int width, int height) override;
         void             make_url(const char* url, const char* basepath, std::string& out) override;
         void             load_image(const char* src, const char* baseurl, bool redraw_on_ready) override;
         void             on_mouse_event(const litehtml::element::ptr& el, litehtml::mouse_event event) override;
@@ -163,6 +171,58 @@ namespace litebrowser
             }
         }
 
+        /// @brief Enable drawing of the document by layers
+        ///
+        /// Must be called before open(). See litehtml::document::get_layers
+        void set_use_layers(bool use_layers)
+        {
+            m_use_layers = use_layers;
+        }
+
+        [[nodiscard]]
+        bool use_layers() const
+        {
+            return m_use_layers;
+        }
+
+        /// @brief Set the memory budget of the images cache, 0 means unlimited
+        ///
+        /// The released images are downloaded again when they are drawn. See cairo_images_cache::set_budget
+        void set_images_budget(size_t bytes)
+        {
+            m_images.set_budget(bytes);
+        }
+
+        /// @brief Must be called by the host after drawing a frame
+        ///
+        /// The images drawn in the last two frames are not released by the images budget, see
+        /// cairo_images_cache::next_frame
+        void next_frame()
+        {
+            m_images.next_frame();
+        }
+
+        void draw_layer(litehtml::uint_ptr hdc, int x, int y, const litehtml::position* clip,
+                        litehtml::uint_ptr layer_id)
+        {
+            std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
+            if(m_html)
+            {
+                m_html->draw_layer(hdc, x, y, clip, layer_id);
+            }
+        }
+
+        litehtml::layer_info::vector get_layers()
+        {
+            litehtml::layer_info::vector          ret;
+            std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
+            if(m_html)
+            {
+                m_html->get_layers(ret);
+            }
+            return ret;
+        }
+
         int render(int max_width)
         {
             std::lock_guard<std::recursive_mutex> html_lock(m_html_mutex);
@@ -240,10 +300,12 @@ namespace litebrowser
             const std::function<void(void* data, size_t len, size_t downloaded, size_t total)>& cb_on_data,
             const std::function<void(u_int32_t http_status, u_int32_t err_code, const std::string& err_text,
                                      const std::string& url)>&                                  cb_on_finish);
-        void on_page_downloaded(std::shared_ptr<text_file> data, u_int32_t http_status, u_int32_t err_code,
-                                const std::string& err_text, const std::string& url);
+        void on_page_data(const std::shared_ptr<litehtml::document_builder>& builder, void* data, size_t len);
+        void on_page_downloaded(const std::shared_ptr<litehtml::document_builder>& builder, u_int32_t http_status,
+                                u_int32_t err_code, const std::string& err_text, const std::string& url);
         void on_image_downloaded(std::shared_ptr<image_file> data, u_int32_t http_status, u_int32_t err_code,
                                  const std::string& err_text, const std::string& url);
+        void download_image(const std::string& url, bool redraw_on_ready);
         void on_pool_update_state();
     };
 } // namespace litebrowser